@@ -0,0 +1,95 @@
+/* File: analyses.cc
+ * -----------------
+ * Implementation of the analysis cache.
+ */
+
+#include "analyses.h"
+
+AnalysisManager::AnalysisManager(vector<TACObject> &code)
+    : hits(0), misses(0), code(code), cfg(NULL), dominators(NULL), loops(NULL), liveness(NULL),
+      defUse(NULL) {}
+
+AnalysisManager::~AnalysisManager() {
+    Invalidate(ANALYSIS_None);
+}
+
+const CFG &AnalysisManager::GetCFG() {
+    if (cfg != NULL) {
+        hits++;
+        return *cfg;
+    }
+    misses++;
+    cfg = new CFG(code);
+    return *cfg;
+}
+
+const Dominators &AnalysisManager::GetDominators() {
+    if (dominators != NULL) {
+        hits++;
+        return *dominators;
+    }
+    const CFG &graph = GetCFG();
+    misses++;
+    dominators = new Dominators(graph);
+    return *dominators;
+}
+
+const LoopInfo &AnalysisManager::GetLoops() {
+    if (loops != NULL) {
+        hits++;
+        return *loops;
+    }
+    const CFG &graph = GetCFG();
+    const Dominators &dom = GetDominators();
+    misses++;
+    loops = new LoopInfo(graph, dom);
+    return *loops;
+}
+
+const Liveness &AnalysisManager::GetLiveness() {
+    if (liveness != NULL) {
+        hits++;
+        return *liveness;
+    }
+    const CFG &graph = GetCFG();
+    misses++;
+    liveness = new Liveness(code, graph);
+    return *liveness;
+}
+
+DefUse &AnalysisManager::GetDefUse() {
+    if (defUse != NULL) {
+        hits++;
+        return *defUse;
+    }
+    misses++;
+    defUse = new DefUse(code);
+    return *defUse;
+}
+
+void AnalysisManager::Invalidate(int preserved) {
+    if (!(preserved & ANALYSIS_CFG))
+        preserved &= ~ANALYSIS_Liveness;
+    if (!(preserved & ANALYSIS_Dominators))
+        preserved &= ~ANALYSIS_Loops;
+    if (!(preserved & ANALYSIS_CFG)) {
+        delete cfg;
+        cfg = NULL;
+    }
+    if (!(preserved & ANALYSIS_Dominators)) {
+        delete dominators;
+        dominators = NULL;
+    }
+    if (!(preserved & ANALYSIS_Loops)) {
+        delete loops;
+        loops = NULL;
+    }
+    if (!(preserved & ANALYSIS_Liveness)) {
+        delete liveness;
+        liveness = NULL;
+    }
+    if (!(preserved & ANALYSIS_DefUse)) {
+        delete defUse;
+        defUse = NULL;
+    }
+}
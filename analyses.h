@@ -0,0 +1,74 @@
+/* File: analyses.h
+ * ----------------
+ * A cache of the analyses of one function's code, shared by the passes
+ * run over it.
+ *
+ * An analysis is computed the first time a pass asks for it and kept
+ * until the code changes in a way that makes it stale. A pass that
+ * changes the code says which analyses it leaves valid, and the pass
+ * manager drops the others after it. A pass that changes the code
+ * partway through and wants an analysis of the new code invalidates
+ * the cache itself before asking again.
+ *
+ * The dominators and loops describe the graph by block numbers only, so
+ * they can be kept across a change that leaves every block and edge
+ * where it was, such as inserting or removing instructions inside
+ * blocks, even though the CFG itself, with its instruction ranges, is
+ * stale then. Dropping the CFG drops the liveness too, and dropping the
+ * dominators drops the loops. The def-use chains don't depend on the
+ * graph; a pass that edits the code through them keeps them valid.
+ */
+
+#ifndef _H_analyses
+#define _H_analyses
+
+#include "tac.h"
+#include "cfg.h"
+#include "dominators.h"
+#include "loops.h"
+#include "liveness.h"
+#include "defuse.h"
+#include <vector>
+using namespace std;
+
+enum AnalysisKind {
+    ANALYSIS_None = 0,
+    ANALYSIS_CFG = 1,
+    ANALYSIS_Dominators = 2,
+    ANALYSIS_Loops = 4,
+    ANALYSIS_Liveness = 8,
+    ANALYSIS_DefUse = 16,
+    ANALYSIS_All = 31
+};
+
+class AnalysisManager {
+  public:
+    int hits, misses;           // requests answered from the cache or not
+
+    AnalysisManager(vector<TACObject> &code);
+    ~AnalysisManager();
+
+    const CFG &GetCFG();
+    const Dominators &GetDominators();
+    const LoopInfo &GetLoops();
+    const Liveness &GetLiveness();
+    // Changes made through the chains keep them valid, so they are not
+    // const
+    DefUse &GetDefUse();
+
+    // Drops every analysis not in the preserved set of ANALYSIS_ flags
+    void Invalidate(int preserved);
+
+  private:
+    vector<TACObject> &code;
+    CFG *cfg;
+    Dominators *dominators;
+    LoopInfo *loops;
+    Liveness *liveness;
+    DefUse *defUse;
+
+    AnalysisManager(const AnalysisManager &);
+    void operator=(const AnalysisManager &);
+};
+
+#endif
@@ -6,13 +6,14 @@
 #include "ast_type.h"
 #include "ast_decl.h"
 #include "symtable.h"
+#include "analyses.h"
 #include <string.h> // strdup
 #include <stdio.h>  // printf
 #include <string>
 #include <vector>
 #include <ctype.h>
 #include <stdlib.h>
-#include <map>
+#include <unordered_set>
 using namespace std;
 
 Node::Node(yyltype loc) {
@@ -28,8 +29,11 @@ Node::Node() {
 SymbolTable *Node::symtab = new SymbolTable();
 int Node::varNotInitCounter = 0;
 int Node::registerCounter = 1; // start with 1 for convenience assigning name for registers
-int Node::labelCounter = 0;
-vector<TACObject> Node::TACContainer = {};
+vector<TACFunction*> Node::functions;
+TACFunction *Node::currentFunction = NULL;
+unordered_set<Operand, OperandHash> Node::definedVars;
+unordered_map<int, int> Node::globalSlots;
+int Node::numGlobalSlots = 0;
 
 /* The Print method is used to print the parse tree nodes.
  * If this node has a location (most nodes do, but some do not), it
@@ -51,9 +55,46 @@ void Node::Print(int indentLevel, const char *label) {
    PrintChildren(indentLevel);
 } 
 	 
-string Node::Emit() {
+TACFunction *Node::CurrentFunction() {
+    if (currentFunction == NULL) {
+        currentFunction = new TACFunction();
+        functions.push_back(currentFunction);
+    }
+    return currentFunction;
+}
+
+Operand Node::NewTemp() {
+    TACFunction *fn = CurrentFunction();
+    int slot = fn->IsTopLevel() ? numGlobalSlots++ : fn->NewSlot();
+    return Operand::Temp(registerCounter++, slot);
+}
+
+Operand Node::ResolveVar(const char *name, bool declare) {
+    int id = InternName(name);
+    TACFunction *fn = CurrentFunction();
+    unordered_map<int, int>::iterator it;
+    if (fn->IsTopLevel()) {
+        it = globalSlots.find(id);
+        if (it == globalSlots.end())
+            it = globalSlots.insert(make_pair(id, numGlobalSlots++)).first;
+        return Operand::Global(id, it->second);
+    }
+    it = fn->varSlots.find(id);
+    if (it != fn->varSlots.end())
+        return Operand::Var(id, it->second);
+    if (!declare) {
+        it = globalSlots.find(id);
+        if (it != globalSlots.end())
+            return Operand::Global(id, it->second);
+    }
+    int slot = fn->NewSlot();
+    fn->varSlots[id] = slot;
+    return Operand::Var(id, slot);
+}
+
+Operand Node::Emit() {
     cout << "In Node class's Emit()" << endl;
-    return NULL;
+    return Operand();
 }     
 Identifier::Identifier(yyltype loc, const char *n) : Node(loc) {
     name = strdup(n);
@@ -65,112 +106,77 @@ void Identifier::PrintChildren(int indentLevel) {
 
 // ==========================================
 // 
-bool is_number(const std::string& s)
-{
-    return( strspn( s.c_str(), "-.0123456789" ) == s.size() );
+// Name assigned by a plain copy, or none for any other kind of TAC
+static Operand assignedVar(const TACObject &t) {
+    return t.type == TAC_Assign ? t.dst : Operand();
 }
 
-vector<string> createVarList(vector<TACObject> currTac){
-    vector<string> varList = {};
-    for (int i = 0; i < currTac.size(); i++){
-        if(currTac[i].type == 2){
-           
-            string varName = currTac[i].localVarName;
-            if(std::find(varList.begin(), varList.end(),varName)==varList.end()){
-                varList.push_back(varName);
-                //cout << "here:" << varName << endl;
-            }
-        }
-    }
-
-    return varList;
-}
 // 3 options:  1: no optimization for 3 const params. 
 //             2: Deal with 3 or more const params, but changed all t1 := ~~~, x := t1  to  x := ~~~
 //             3: trace back to detect is there a temp var has been folded before. 
 //             
 //             Using 3 right now.
-vector<TACObject> constantFolding(vector<TACObject> tac)
+bool constantFolding(vector<TACObject> &tac, AnalysisManager &analyses)
 {   
-    //return tac;
-    vector<TACObject> improvedTac;
+    //return false;
+    bool changed = false;
+    const CFG &cfg = analyses.GetCFG();
     
     for (int i = 0; i < tac.size(); i++) {
-        if(tac[i].type == 12 ){
-            TACObject newTacObj;
-            if(is_number(tac[i].lhs) && is_number(tac[i].rhs)){
-                int l = std::stoi(tac[i].lhs);
-                int r = std::stoi(tac[i].rhs);
-                int result = 0;
-                newTacObj.type = 2;
-                
-
-                if(tac[i].ops == "+"){
-                    result = l + r;  
-                }
-                else if(tac[i].ops == "-"){
-                    result = l - r;
-                }
-                else if(tac[i].ops == "*"){
-                    result = l * r;
-                }
-                else if(tac[i].ops == "/"){
-                    result = l / r;
-                }
-
-
-                newTacObj.localAssignedValue = std::to_string(result);
-                newTacObj.id = tac[i + 1].id;
-                newTacObj.countedAllocation = tac[i + 1].countedAllocation;
-                newTacObj.getFolded = 1;
-
-                if(tac[i+1].type == 2)
-                {   
-                    newTacObj.localVarName = tac[i+1].localVarName;
-                    i++;
-                }
-                else if(tac[i + 1].type == 12){
-                    newTacObj.localVarName = tac[i].toCurVar;
-                }
-                
-                
-
-                improvedTac.push_back(newTacObj);
+        Operand result;
+        if(tac[i].type == TAC_BinaryOp && tac[i].src1.IsConstant() && tac[i].src2.IsConstant() &&
+           FoldOperation(tac[i].ops, tac[i].src1, tac[i].src2, result)){
+            TACObject &folded = tac[i];
+            folded.type = TAC_Assign;
+            folded.ops = OP_None;
+            folded.src1 = result;
+            folded.src2 = Operand();
+            folded.getFolded = 1;
+            changed = true;
+
+            if(i + 1 < tac.size() && cfg.blockOf[i + 1] == cfg.blockOf[i] &&
+               tac[i+1].type == TAC_Assign && tac[i+1].src1 == folded.dst)
+            {   
+                folded.dst = tac[i+1].dst;
+                folded.declares = tac[i+1].declares;
+                tac[i+1].deadMarked = 1;
+                i++;
             }
-            else{
-                improvedTac.push_back(tac[i]);
-            }
-        }
-        else{
-            improvedTac.push_back(tac[i]);
         }
     }
+    RemoveDeadMarked(tac);
+    // folding never adds or removes a block
+    if (changed)
+        analyses.Invalidate(ANALYSIS_Dominators | ANALYSIS_Loops);
 
     // option 2:
     // eliminate  t1 = 2 + y;  x = t1;  => x = 2 + y
-    //cout << " --in position--" << improvedTac.size()<< endl;
-    // for (int i = 0; i < improvedTac.size() - 1; i++) {
-    //     if(improvedTac[i].type == 12 && improvedTac[i + 1].type == 2 && improvedTac[i].toCurVar == improvedTac[i + 1].localAssignedValue )
+    // for (int i = 0; i + 1 < tac.size(); i++) {
+    //     if(tac[i].type == TAC_BinaryOp && tac[i + 1].type == TAC_Assign && tac[i].dst == tac[i + 1].src1 )
     //     {   
-    //         improvedTac[i].toCurVar = improvedTac[i + 1].localVarName;
-    //         improvedTac[i + 1].type  = 0;
+    //         tac[i].dst = tac[i + 1].dst;
+    //         tac[i + 1].deadMarked = 1;
     //     }
 
     // }
     
 
-    // option 3.
-    for (int i = 0; i < improvedTac.size() - 1; i++) {
-        if(improvedTac[i].type == 12 && improvedTac[i + 1].type == 2 && improvedTac[i].toCurVar == improvedTac[i + 1].localAssignedValue )
+    // option 3. only looks back within the basic block
+    const CFG &improvedCfg = analyses.GetCFG();
+    for (int i = 0; i + 1 < tac.size(); i++) {
+        int block = improvedCfg.blockOf[i];
+        if(tac[i].type == TAC_BinaryOp && tac[i + 1].type == TAC_Assign &&
+           improvedCfg.blockOf[i + 1] == block && tac[i].dst == tac[i + 1].src1 )
         {   
             bool detect = true;
             int index = i;
-            while(index >= 1 &&  detect){
-                if(improvedTac[index].lhs != improvedTac[index - 1].localVarName && improvedTac[index].rhs != improvedTac[index - 1].localVarName){
+            while(index >= 1 && improvedCfg.blockOf[index - 1] == block && detect){
+                Operand prev = assignedVar(tac[index - 1]);
+                if(tac[index].src1 != prev && tac[index].src2 != prev){
                     detect = false;
                 }
                 else{
-                    if(improvedTac[index - 1].getFolded == 0){
+                    if(tac[index - 1].getFolded == 0){
                         detect = false;
                     }
                     else{
@@ -183,382 +189,205 @@ vector<TACObject> constantFolding(vector<TACObject> tac)
             }
 
             if(detect == true){
-                improvedTac[i].toCurVar = improvedTac[i + 1].localVarName;
-                improvedTac[i + 1].type  = 0;
+                tac[i].dst = tac[i + 1].dst;
+                tac[i + 1].type  = TAC_Nop;
+                tac[i + 1].deadMarked = 1;
+                changed = true;
             }
         }
 
     }
-    return improvedTac;
+    RemoveDeadMarked(tac);
+    return changed;
 }
 
 
-// My option: disable optimization when x = 1; x = 2;  or  t1 = a(value) + b(value); x = t1. <-- after this line
-vector<TACObject> constantPropogation(vector<TACObject> tac)
-{   
-    vector<TACObject> improvedTac;
-    bool needOpt = true;
-    bool ifElseBlockUsed = false;
-    bool inAIfElseBlock = false;
-
-    std::map<std::string, std::string> varMap;
-
-
-    // using a loop to check out which assign I should keep in type
-    for (int i = 0; i < tac.size(); i++){
-        TACObject newTacObj;
-
-        // solve the issue for one extra assignment in if else block
-        if(tac[i].type == 10){
-            inAIfElseBlock = true;
-            ifElseBlockUsed = false;
-        }
-        if(tac[i].endOfIf == 1){
-            inAIfElseBlock = false;
-            ifElseBlockUsed = false;
-        }
-
-
-        if(tac[i].type == 12 ){
-            if(varMap.find(tac[i].lhs) != varMap.end() && needOpt){
-
-                //cout <<" :" << tac[i].toCurVar << endl;
-                if(varMap.find(tac[i].toCurVar) != varMap.end()){
-                    if(inAIfElseBlock && ifElseBlockUsed == false){
-                        ifElseBlockUsed = true;
-                    }
-                    else{
-                        needOpt = false;
-                    }
-                }
-                else{
-                    newTacObj.id = tac[i].id;
-                    newTacObj.lhs = varMap[tac[i].lhs];
-                    newTacObj.rhs = tac[i].rhs;
-                    newTacObj.ops = tac[i].ops;
-                    newTacObj.type = 12;
-                    newTacObj.toCurVar = tac[i].toCurVar;
-                    newTacObj.countedAllocation = tac[i].countedAllocation; 
-                }
-                
-            }
-            if(varMap.find(tac[i].rhs) != varMap.end() && needOpt ){
-                
-                
-                if(varMap.find(tac[i].toCurVar) != varMap.end()){
-                    if(inAIfElseBlock && ifElseBlockUsed == false){
-                        ifElseBlockUsed = true;
-                    }
-                    else{
-                        needOpt = false;
-                    }
-                }
-
-                // if y = a + b.
-                else if(newTacObj.type == 12){
-                    newTacObj.rhs = varMap[tac[i].rhs];
-                    
-                }
-                else{
-                    newTacObj.id = tac[i].id;
-                    newTacObj.lhs = tac[i].lhs;
-                    newTacObj.rhs = varMap[tac[i].rhs];
-                    newTacObj.ops = tac[i].ops;
-                    newTacObj.type = 12;
-                    newTacObj.toCurVar = tac[i].toCurVar;
-                    newTacObj.countedAllocation = tac[i].countedAllocation; 
-                    
-                }
-
-
-            }
-
-
-        }
-
-        if(tac[i].type == 2 ){
-
-            if(varMap.find(tac[i].localVarName) != varMap.end()){
-                if(inAIfElseBlock && ifElseBlockUsed == false){
-                        ifElseBlockUsed = true;
-                    }
-                    else{
-                        needOpt = false;
-                    }
-            }
-
-            if(is_number(tac[i].localAssignedValue)){
-                varMap[tac[i].localVarName] = tac[i].localAssignedValue;
-            }
+// Whether an instruction does nothing but write its result
+static bool isRemovable(const TACObject &t) {
+    return (t.type == TAC_Assign || t.type == TAC_BinaryOp || t.type == TAC_Phi) &&
+           !t.dst.IsGlobal();
+}
 
-            if(varMap.find(tac[i].localAssignedValue) != varMap.end() && needOpt){
+// Erases instruction i, noting the values it read: one of them may have
+// no reads left now
+static void eraseDead(int i, vector<TACObject> &tac, DefUse &chains, vector<Operand> &reads) {
+    const TACObject &t = tac[i];
+    if (t.src1.IsValue())
+        reads.push_back(t.src1);
+    if (t.src2.IsValue())
+        reads.push_back(t.src2);
+    if (t.type == TAC_Phi) {
+        const vector<Operand> &args = PhiArgs(tac[i]);
+        reads.insert(reads.end(), args.begin(), args.end());
+    }
+    chains.Erase(i);
+}
 
-                
-                newTacObj.id = tac[i].id;
-                newTacObj.type = 2;
-                newTacObj.localAssignedValue = varMap[tac[i].localAssignedValue];
-                newTacObj.localVarName = tac[i].localVarName;
-                newTacObj.countedAllocation = tac[i].countedAllocation; 
-                
-            }
+// Adds delta to the count of reads, by frame slot, of each value t reads,
+// returning whether one read in other blocks than it is written in drops
+// to none
+static bool countReads(const TACObject &t, vector<int> &reads, int delta, const Liveness &liveness) {
+    bool none = false;
+    Operand uses[2];
+    int numUses = UsesOf(t, uses);
+    for (int k = 0; k < numUses; k++) {
+        if (!uses[k].IsGlobal() && (reads[uses[k].slot] += delta) == 0)
+            none |= liveness.IndexOf(uses[k]) >= 0;
+    }
+    if (t.type == TAC_Phi) {
+        const vector<Operand> &args = PhiArgs(t);
+        for (int k = 0; k < args.size(); k++) {
+            if (args[k].IsValue() && !args[k].IsGlobal() && (reads[args[k].slot] += delta) == 0)
+                none |= liveness.IndexOf(args[k]) >= 0;
         }
+    }
+    return none;
+}
 
-
-        if(newTacObj.type == 0){
-            improvedTac.push_back(tac[i]);
-        }
-        else{
-            improvedTac.push_back(newTacObj);
+// Whether removing the dead instructions takes away the last read of a
+// value live across blocks. Counting the reads is much cheaper than
+// building the def-use chains, which only help when that happens.
+static bool lastReadRemoved(const vector<TACObject> &tac, const vector<int> &dead,
+                            const Liveness &liveness) {
+    int slots = 0;
+    for (int i = 0; i < tac.size(); i++) {
+        slots = max(slots, (int)tac[i].src1.slot + 1);
+        slots = max(slots, (int)tac[i].src2.slot + 1);
+        if (tac[i].type == TAC_Phi) {
+            const vector<Operand> &args = PhiArgs(tac[i]);
+            for (int k = 0; k < args.size(); k++)
+                slots = max(slots, (int)args[k].slot + 1);
         }
-
     }
-
-    return improvedTac;
+    vector<int> reads(slots);
+    for (int i = 0; i < tac.size(); i++)
+        countReads(tac[i], reads, 1, liveness);
+    bool none = false;
+    for (int k = 0; k < dead.size(); k++)
+        none |= countReads(tac[dead[k]], reads, -1, liveness);
+    return none;
 }
 
-
-struct usedList
+// Removes copies and operations whose result is never read on any path.
+// Each block is walked backwards starting from what is live on its way
+// out, so a read anywhere later, around a loop or down either side of a
+// branch, keeps a definition. Removing an instruction can leave the ones
+// feeding it dead in turn. Inside a block the walk sees that itself.
+// Across blocks, a value whose last read went is dead wherever it is
+// written, which the def-use chains find without looking at the rest of
+// the code; what that misses, a value still read somewhere but not after
+// one of its definitions, the next round finds, and this repeats until
+// nothing changes. The analyses the last round asked for still describe
+// the code left.
+bool deadCodeElimination(vector<TACObject> &tac, AnalysisManager &analyses)
 {
-    int used[99] = {};
-    int size = 0;
-};
-
-// if code not used in if else and after if-esle. remove it.
-vector<TACObject> deadCodeElimination(vector<TACObject> tac)
-{
-    vector<TACObject> improvedTac;
-    // key to store var, 
-    std::map<std::string, usedList> usedMap;
-    std::map<std::string, usedList> unusedMap;
-
-    bool inLoop = false; 
-
-    for (int i = 0; i < tac.size(); i++){
-
-        if(tac[i].type == 10){
-            usedList newUnused;
-            newUnused.used[newUnused.size] = i;
-            newUnused.size += 1;
-            usedMap[tac[i].conditionVar] = newUnused;
-        }
-        if(tac[i].type == 12){
-            if(unusedMap.find(tac[i].toCurVar) == unusedMap.end()){
-                usedList newUnused;
-                newUnused.used[newUnused.size] = i;
-                newUnused.size += 1;
-
-                unusedMap[tac[i].toCurVar] = newUnused;
-            }
-            else{
-                usedList existUnused = unusedMap[tac[i].toCurVar];
-                existUnused.used[existUnused.size] = i;
-                existUnused.size += 1;
-
-                unusedMap[tac[i].toCurVar] = existUnused;
-            }
-            
-
-            if(is_number(tac[i].lhs) == false){
-
-                if(usedMap.find(tac[i].lhs) == usedMap.end()){
-                    usedList newUsedAssign;
-                    newUsedAssign.used[newUsedAssign.size] = i;
-                    newUsedAssign.size += 1;
-                    
-                    usedMap[tac[i].lhs] = newUsedAssign;
+    int removed = 0;
+    vector<int> dead;
+    vector<Operand> reads;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        bool readAcrossBlocks = false;
+        const CFG &cfg = analyses.GetCFG();
+        const Liveness &liveness = analyses.GetLiveness();
+        vector<Operand> exitUses;
+        BitVector live(liveness.NumValues());
+
+        for (int b = 0; b < cfg.NumBlocks(); b++) {
+            // values live across blocks are in the bit vector, the ones
+            // only used inside this block in the set
+            const vector<int> &out = liveness.liveOut[b];
+            for (int k = 0; k < out.size(); k++)
+                live.Set(out[k]);
+            unordered_set<Operand, OperandHash> liveHere;
+            exitUses.clear();
+            PhiUsesOnExit(tac, cfg, b, exitUses);
+            for (int k = 0; k < exitUses.size(); k++) {
+                int u = liveness.IndexOf(exitUses[k]);
+                if (u >= 0) {
+                    live.Set(u);
                 }
-                else{
-                    usedList existUnsed = usedMap[tac[i].lhs];
-                    existUnsed.used[existUnsed.size] = i;
-                    existUnsed.size += 1;
-                    usedMap[tac[i].lhs] = existUnsed;
+                else {
+                    liveHere.insert(exitUses[k]);
                 }
-
-
-                // usedList newLeftUsed;
-                // newLeftUsed.used[newLeftUsed.size] = i;
-                // newLeftUsed.size += 1;
-
-                // usedMap[tac[i].lhs] = newLeftUsed;
             }
 
-            if(is_number(tac[i].rhs) == false){
-                if(usedMap.find(tac[i].rhs) == usedMap.end()){
-                    usedList newUsedAssign;
-                    newUsedAssign.used[newUsedAssign.size] = i;
-                    newUsedAssign.size += 1;
-                    
-                    usedMap[tac[i].rhs] = newUsedAssign;
-                }
-                else{
-                    usedList existUnsed = usedMap[tac[i].rhs];
-                    existUnsed.used[existUnsed.size] = i;
-                    existUnsed.size += 1;
-                    usedMap[tac[i].rhs] = existUnsed;
-                }
-
-
-                // usedList newRightUsed;
-                // newRightUsed.used[newRightUsed.size] = i;
-                // newRightUsed.size += 1;
-                
-                // usedMap[tac[i].rhs] = newRightUsed;
-            }
-            
-        }
-
-        if(tac[i].type == 2){
-
-            if(unusedMap.find(tac[i].localVarName) == unusedMap.end() ){
-                usedList newUnused1;
-                newUnused1.used[newUnused1.size] = i;
-                newUnused1.size += 1;
-                unusedMap[tac[i].localVarName] = newUnused1;
-            }
-            else{
-                usedList existUnunsed = unusedMap[tac[i].localVarName];
-                existUnunsed.used[existUnunsed.size] = i;
-                existUnunsed.size += 1;
-                unusedMap[tac[i].localVarName] = existUnunsed;
-            }
-            
-
-            
-
-            if(is_number(tac[i].localAssignedValue) == false){
-
-                if(usedMap.find(tac[i].localAssignedValue) == usedMap.end()){
-                    usedList newUsedAssign;
-                    newUsedAssign.used[newUsedAssign.size] = i;
-                    newUsedAssign.size += 1;
-                    
-                    usedMap[tac[i].localAssignedValue] = newUsedAssign;
-                }
-                else{
-                    usedList existUnsed = usedMap[tac[i].localAssignedValue];
-                    existUnsed.used[existUnsed.size] = i;
-                    existUnsed.size += 1;
-                    usedMap[tac[i].localAssignedValue] = existUnsed;
-                }
-
-            }
-        }
-
-    }
-
-    // for(auto elem : unusedMap)
-    // {
-    //    std::cout << elem.first << " " << elem.second.used[0] << endl;
-    // }
-    
-
-    //type = 2:  if currVar < nearest used && no other currVar in next few lines before the nearest used
-    
-    for (int i = 0; i < tac.size(); i++){
-        //TACObject newTacObj;
-
-
-        if(tac[i].type == 13 ){
-            string labelName = tac[i].label;
-
-            for(int j = i; j < tac.size(); j++){
-                if(tac[j].type == 11 && tac[j].targetLocation == labelName && tac[j].endOfForLoop == 1){
-                    inLoop = true;
-                }
-            }
-
-            if(tac[i].endOfForLoop == 1){
-                inLoop = false;
-            }
-        }
-
-        if(tac[i].type == 2){
-
-            if(usedMap.find(tac[i].localVarName) == usedMap.end()){
-                tac[i].deadMarked = 1;
-            }
-            else{
-                usedList findUsed = usedMap[tac[i].localVarName];
-                int nearestUsed = -1;
-                // find nearest used.
-                for(int j = 0; j < findUsed.size; j++){
-                    if(i < findUsed.used[j]){
-                        nearestUsed = findUsed.used[j];
-                        break;
+            for (int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].begin; i--) {
+                TACObject &t = tac[i];
+                if (DefinesValue(t)) {
+                    int d = liveness.IndexOf(t.dst);
+                    bool isLive = t.dst.IsGlobal() || (d >= 0 ? live.Test(d) : liveHere.count(t.dst) > 0);
+                    if (!isLive && isRemovable(t)) {
+                        Operand uses[2];
+                        for (int k = UsesOf(t, uses) - 1; k >= 0; k--)
+                            readAcrossBlocks |= liveness.IndexOf(uses[k]) >= 0;
+                        readAcrossBlocks |= t.type == TAC_Phi;
+                        dead.push_back(i);
+                        changed = true;
+                        continue;
                     }
-                }
-                
-                if(nearestUsed == -1){
-                    tac[i].deadMarked = 1;
-                }
-                // find next assign to same variable between i and nearetUsed
-                
-                for (int j = i + 1; j < nearestUsed; j++){
-                    if(tac[i].localVarName == tac[j].localVarName){
-                        tac[i].deadMarked = 1;
-                        break;
+                    if (d >= 0) {
+                        live.Reset(d);
+                    }
+                    else {
+                        liveHere.erase(t.dst);
                     }
                 }
-            }
-            
-        }
 
-
-        if(tac[i].type == 12){
-            if(usedMap.find(tac[i].toCurVar) == usedMap.end()){
-                tac[i].deadMarked = 1;
-            }
-            else{
-                usedList findUsed = usedMap[tac[i].toCurVar];
-                int nearestUsed = -1;
-                // find nearest used.
-                for(int j = 0; j < findUsed.size; j++){
-                    if(i < findUsed.used[j]){
-                        nearestUsed = findUsed.used[j];
-                        break;
+                Operand uses[2];
+                int numUses = UsesOf(t, uses);
+                for (int k = 0; k < numUses; k++) {
+                    int u = liveness.IndexOf(uses[k]);
+                    if (u >= 0) {
+                        live.Set(u);
                     }
-                }
-                
-                if(nearestUsed == -1){
-                    tac[i].deadMarked = 1;
-                }
-                // find next assign to same variable between i and nearetUsed
-                
-                for (int j = i + 1; j < nearestUsed; j++){
-                    if(tac[i].toCurVar == tac[j].toCurVar){
-                        tac[i].deadMarked = 1;
-                        break;
+                    else {
+                        liveHere.insert(uses[k]);
                     }
                 }
             }
+
+            // what is still set is live on entry, so clearing that leaves
+            // the vector empty for the next block
+            const vector<int> &in = liveness.liveIn[b];
+            for (int k = 0; k < in.size(); k++)
+                live.Reset(in[k]);
         }
 
-        if(tac[i].type == 2){
-            string assignVar = tac[i].localAssignedValue;
-            string subs = assignVar.substr(1, assignVar.length());
-            char firstChar = char(assignVar.at(0));
-            if(firstChar == 't' && is_number(subs)){
-                tac[i].deadMarked = 0;
+        if (!changed)
+            break;
+        if (!readAcrossBlocks || !lastReadRemoved(tac, dead, liveness)) {
+            for (int k = 0; k < dead.size(); k++)
+                tac[dead[k]].deadMarked = 1;
+            dead.clear();
+            removed += RemoveDeadMarked(tac);
+            analyses.Invalidate(ANALYSIS_None);
+            // the walk already found everything that only fed what it
+            // removed; unless that read values live in other blocks,
+            // another round would find nothing
+            if (!readAcrossBlocks)
+                break;
+            continue;
+        }
+        DefUse &chains = analyses.GetDefUse();
+        for (int k = 0; k < dead.size(); k++)
+            eraseDead(dead[k], tac, chains, reads);
+        dead.clear();
+        // a value whose last read went is dead wherever it is written
+        while (!reads.empty()) {
+            Operand v = reads.back();
+            reads.pop_back();
+            if (!v.IsValue() || v.IsGlobal() || chains.NumUses(v) > 0)
+                continue;
+            for (int d = chains.NumDefs(v) - 1; d >= 0; d--) {
+                int i = chains.DefAt(v, d);
+                if (isRemovable(tac[i]))
+                    eraseDead(i, tac, chains, reads);
             }
         }
 
-        // if(tac[i].type ==12){
-        //     string assignVar = tac[i].toCurVar;
-        //     string subs = assignVar.substr(1, assignVar.length());
-        //     char firstChar = char(assignVar.at(0));
-        //     if(firstChar == 't' && is_number(subs)){
-        //         tac[i].deadMarked = 0;
-        //     }
-        // }
-
-
-
-        if(tac[i].deadMarked == 0 || inLoop == true){
-            improvedTac.push_back(tac[i]);
-        }
+        removed += chains.Compact();
+        analyses.Invalidate(ANALYSIS_DefUse);
     }
 
-
-    return improvedTac;
+    return removed > 0;
 }
-
@@ -6,7 +6,6 @@
 #include "ast_type.h"
 #include "ast_stmt.h"
 #include "symtable.h"
-#include "string"
 Decl::Decl(Identifier *n) : Node(*n->GetLocation()) {
     Assert(n != NULL);
     (id=n)->SetParent(this);
@@ -25,19 +24,19 @@ void VarDecl::PrintChildren(int indentLevel) {
    if (assignTo) assignTo->Print(indentLevel+1, "(initializer) ");
 }
 //TODO
-string VarDecl::Emit() {
+Operand VarDecl::Emit() {
     
-    string varName = GetIdentifier()->GetName();
+    Operand var = ResolveVar(GetIdentifier()->GetName(), true);
     TACObject newTac;
     
     if (assignTo) {
-        string rhsRegisterName = assignTo->Emit();
-        newTac.id = varName;
-        newTac.type = 2;
-        newTac.countedAllocation = 1;
-        newTac.localAssignedValue = rhsRegisterName;
-        newTac.localVarName = varName;
-        //newTac.line = string("    ") + varName + string(" := ") + rhsRegisterName;
+        Operand rhs = assignTo->Emit();
+        newTac.declares = 1;
+        newTac.type = TAC_Assign;
+        AllocateSlot();
+        newTac.src1 = rhs;
+        newTac.dst = var;
+        definedVars.insert(var);
 
         // if global var, type = 3.
         // 
@@ -54,13 +53,13 @@ string VarDecl::Emit() {
         // }
         // if var in function, type = 1.
         //newTac.type = typeResult;
-        TACContainer.push_back(newTac);    
+        AppendTAC(newTac);
     }
     
 
     
 
-    return "VarDecl::Emit()";
+    return Operand();
 }
 
 
@@ -77,74 +76,49 @@ void FnDecl::SetFunctionBody(Stmt *b) {
 }
 
 
-//TODO not complete count part
-//
-string FnDecl::Emit() {
-    string varName = id->GetName();
+// The function gets its own TAC buffer. BeginFunc is emitted up front
+// and its size filled in once the body has allocated all its slots.
+Operand FnDecl::Emit() {
+    currentFunction = new TACFunction(Operand::Func(id->GetName()));
+    functions.push_back(currentFunction);
+    definedVars.clear();
+
     TACObject funcName;
-    //funcName.id = " ";
-    //funcName.line = varName + ":";
-    funcName.type = 3;
-    funcName.trigger = 1;
-    funcName.functionName = varName;
-    TACContainer.push_back(funcName);
-
-    int count = 0;
+    funcName.type = TAC_FuncLabel;
+    funcName.src1 = currentFunction->name;
+    AppendTAC(funcName);
+
     for(int i = 0; i < formals->NumElements(); i++) {
         formals->Nth(i)->Emit();
         VarDecl* v = formals->Nth(i);
-        string sname = v->GetIdentifier()->GetName();
 
         TACObject newTac ;
-        newTac.id = sname;
-        newTac.type = 77;
-        newTac.loadVarName = sname;
-        newTac.countedAllocation = 1;
-        //newTac.line = string("    ") + "LoadParam" + string(" ") + sname;
-        //newTac.type = 1;
-        count++;
-        TACContainer.push_back(newTac); 
+        newTac.declares = 1;
+        newTac.type = TAC_LoadParam;
+        newTac.dst = ResolveVar(v->GetIdentifier()->GetName());
+        newTac.src1 = Operand::Int(i);
+        definedVars.insert(newTac.dst);
+        AllocateSlot();
+        AppendTAC(newTac);
     }
-    int bcount = 0;
     if(body){
-        body->Emit();
+        TACObject beginFunc;
+        beginFunc.type = TAC_BeginFunc;
+        currentFunction->beginFunc = currentFunction->code.size();
+        AppendTAC(beginFunc);
 
-        for(int i = 0; i < TACContainer.size(); i++){
-            if(TACContainer[i].countedAllocation == 1){
-                bcount++;
-                //cout << "warning:" << TACContainer[i].id <<endl;
-                TACContainer[i].countedAllocation = 0;
-            }
-        }
-
-
-        bcount = bcount * 4;
-        TACObject test ;
-        
-        int loc = 0;
-        for (int i=TACContainer.size() - 1; i >= 0; i--){
-            if(TACContainer[i].type == 3 && TACContainer[i].trigger == 1){
-                loc = i;
-                TACContainer[i].trigger = 0;
-            }
-        }
-
-        test.type = 5;
-        test.allocatedSize = std::to_string(bcount);
-        //test.line = string("    BeginFunc ")+  std::to_string(bcount);
-        //test.type = 0;
-        
-        TACContainer.insert(TACContainer.begin()+loc+count + 1, test); 
+        body->Emit();
 
+        int frameSize = currentFunction->frameSize;
+        currentFunction->code[currentFunction->beginFunc].src1 = Operand::Int(frameSize);
     }
     TACObject endFunc ;
-    endFunc.type = 4;
-    //endFunc.id = " ";
-    //
-    // endFunc.line = "    EndFunc ";
-    // endFunc.type = 0;
-    TACContainer.push_back(endFunc);
-    return "FnDecl::Emit()";
+    endFunc.type = TAC_EndFunc;
+    AppendTAC(endFunc);
+
+    // any top-level code that follows goes into a new buffer
+    currentFunction = NULL;
+    return Operand();
 }
 
 void FnDecl::PrintChildren(int indentLevel) {
@@ -47,7 +47,7 @@ class VarDecl : public Decl
     Identifier *GetIdentifier() const { return id; }
     const char *GetPrintNameForNode() { return "VarDecl"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class VarDeclError : public VarDecl
@@ -70,7 +70,7 @@ class FnDecl : public Decl
     void SetFunctionBody(Stmt *b);
     const char *GetPrintNameForNode() { return "FnDecl"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class FormalsError : public FnDecl
@@ -28,6 +28,7 @@ void BoolConstant::PrintChildren(int indentLevel) {
 Operator::Operator(yyltype loc, const char *tok) : Node(loc) {
     Assert(tok != NULL);
     strncpy(tokenString, tok, sizeof(tokenString));
+    tacOp = OperatorFromString(tokenString);
 }
 
 void Operator::PrintChildren(int indentLevel) {
@@ -100,363 +101,166 @@ VarExpr::VarExpr(yyltype loc, Identifier *ident) : Expr(loc) {
   id = ident;
 }
 //finished ====
-string IntConstant::Emit() {
-  return to_string(value);
+Operand IntConstant::Emit() {
+  return Operand::Int(value);
 }
 //finished ====
-string BoolConstant::Emit() {
-  return value ? "true" : "false";
-}
-//finished ====
-string Operator::Emit() {
-  return string(tokenString);
+Operand BoolConstant::Emit() {
+  return Operand::Bool(value);
 }
 
-string Call::Emit() {
+Operand Call::Emit() {
   int count = 0;
-  //int inPrint = 0;
-  //garbage.push_back("11");
-  //
   if(strcmp(field->GetName(),"readIntFromSTDIN") == 0 || strcmp(field->GetName(),"printInt") == 0){
-    string registerString = "t" + to_string(registerCounter);
-    registerCounter++;
     TACObject newTac1;
     
     if(strcmp(field->GetName(),"printInt") == 0 && actuals->NumElements() == 1){
-      string assignto = actuals->Nth(0)->Emit();
+      Operand assignto = actuals->Nth(0)->Emit();
       
-      newTac1.type = 14;
-      newTac1.printInt = assignto;
-      TACContainer.push_back(newTac1); 
-
-      //newTac1.id = " ";
-      //newTac1.line = string("    Print ") + assignto;
-      //inPrint = 1;
-    
+      newTac1.type = TAC_Print;
+      newTac1.src1 = assignto;
+      AppendTAC(newTac1);
+      return Operand();
     }
     else{
-      newTac1.type = 8;
-      newTac1.countedAllocation = 1;
-      newTac1.id = registerString;
-      newTac1.assignToTempVar = registerString;
-      newTac1.callfunctionName = field->GetName();
-      newTac1.paramNum = std::to_string(count);
-      TACContainer.push_back(newTac1); 
-      //newTac1.line =  string("    ") + registerString + string(" call ") + field->GetName() + string(" ") + std::to_string(count);
+      // only a read has a result to take a temporary for
+      Operand registerOperand = NewTemp();
+      newTac1.type = TAC_Call;
+      AllocateSlot();
+      newTac1.declares = 1;
+      newTac1.dst = registerOperand;
+      newTac1.src1 = Operand::Func(field->GetName());
+      newTac1.src2 = Operand::Int(count);
+      AppendTAC(newTac1);
+      return registerOperand;
     }
-    
-    // if global var, type = 3.
-    // 
-    // int typeResult = 1;
-    // for(int i = 0; i < TACContainer.size(); i++){
-    //     std::string eachline = TACContainer[i].line;
-    //     if(eachline.at(0)  != ' '){
-    //         typeResult = 3;
-    //         break;
-    //     }
-    // }
-    // if var in function, type = 1.
-    // if(inPrint == 0){
-    //   newTac1.type = typeResult;
-    // }
-    // else{
-    //   newTac1.type = 0;
-    // }
-
-    
   }
   else{
-    for(int i = 0; i < actuals->NumElements(); i++) {
-        
-        string sname = actuals->Nth(i)->Emit();
-
+    // every argument is evaluated before the first is pushed: the backend
+    // loads $a0-$a3 at the PushParam, and a call in a later argument would
+    // overwrite them
+    vector<Operand> args;
+    for(int i = 0; i < actuals->NumElements(); i++)
+        args.push_back(actuals->Nth(i)->Emit());
+
+    for(int i = 0; i < args.size(); i++) {
         TACObject newTac ;
-        newTac.type = 6;
-        newTac.pushedVarName = sname;
-
-        //newTac.line = string("    ") + "PushParam" + string(" ") + sname;
-        //newTac.type = 0;
-        TACContainer.push_back(newTac); 
+        newTac.type = TAC_PushParam;
+        newTac.src1 = args[i];
+        newTac.src2 = Operand::Int(i);
+        AppendTAC(newTac);
         count++;
     }
     
-    string registerString = "t" + to_string(registerCounter);
-    registerCounter++;
+    Operand registerOperand = NewTemp();
 
     TACObject newTac1;
-    newTac1.type = 8;
-    newTac1.countedAllocation = 1;
-    newTac1.assignToTempVar = registerString;
-    newTac1.id = registerString;
-    newTac1.callfunctionName = field->GetName();
-    newTac1.paramNum = std::to_string(count);
-
-    TACContainer.push_back(newTac1); 
-    //newTac1.id = " ";
-    //newTac1.line =  string("    ") + registerString + string(" call ") + field->GetName() + string(" ") + std::to_string(count);
-    
-    // if global var, type = 3.
-    // 
-    // int typeResult = 1;
-    // for(int i = 0; i < TACContainer.size(); i++){
-    //     std::string eachline = TACContainer[i].line;
-    //     if(eachline.at(0)  != ' '){
-    //         typeResult = 3;
-    //         break;
-    //     }
-    // }
-    // // if var in function, type = 1.
-    // newTac1.type = typeResult;
-
+    newTac1.type = TAC_Call;
+    AllocateSlot();
+    newTac1.declares = 1;
+    newTac1.dst = registerOperand;
+    newTac1.src1 = Operand::Func(field->GetName());
+    newTac1.src2 = Operand::Int(count);
+    AppendTAC(newTac1);
 
-
-    
     count = count * 4;
 
     TACObject newTac2 ;
-    newTac2.type = 7;
-    newTac2.poppedVarName = std::to_string(count);
-    TACContainer.push_back(newTac2); 
-
-    //newTac2.id = " ";
-    //newTac2.line =  string("    ") + string("PopParam ") + std::to_string(count);
-    //newTac2.type = 0;
-    
+    newTac2.type = TAC_PopParam;
+    newTac2.src1 = Operand::Int(count);
+    AppendTAC(newTac2);
+    return registerOperand;
   }
-  //garbage.pop_back();
-  //Decl* returnDecl = symtab->FindSymbolInAllScopes(field->GetName());
-  return "t" + to_string(registerCounter - 1);;
 }
 
 
-//TODO
-string VarExpr::Emit() {
-  string localVarName = id->GetName();
-  return string(localVarName);
+Operand VarExpr::Emit() {
+  return ResolveVar(id->GetName());
 }
 
-string EmptyExpr::Emit() {
-  return "EmptyExpr Emit";
+Operand EmptyExpr::Emit() {
+  return Operand();
 }
-//TODO
-string ArithmeticExpr::Emit() {
-  string leftString = left->Emit();
-  string rightString = right->Emit();
-  string opString = op->Emit();
-
-  string registerString = "t" + to_string(registerCounter);
-  registerCounter++;
-  
-  TACObject newTac;
-  newTac.type = 12;
-  newTac.lhs = leftString;
-  newTac.rhs = rightString;
-  newTac.ops = opString;
-  newTac.toCurVar = registerString;
-  newTac.id = registerString;
-  newTac.countedAllocation = 1;
-  TACContainer.push_back(newTac);   
-
-  //newTac.id = " ";
-  //newTac.line =  string("    ") + registerString + string(" := ") + leftString + string(" ") + opString + string(" ") + rightString;
-  //int typeResult = 1;
-  // for(int i = 0; i < TACContainer.size(); i++){
-  //     std::string eachline = TACContainer[i].line;
-  //     if(eachline.at(0)  != ' '){
-  //         typeResult = 3;
-  //         break;
-  //     }
-  // }
-  // if var in function, type = 1.
-  //newTac.type = typeResult;
-  
 
-  return registerString;
-}
-
-string RelationalExpr::Emit() {
-  string leftString = left->Emit();
-  string rightString = right->Emit();
-  string opString = op->Emit();
+// Emits `t := left op right` and returns t; shared by the binary
+// arithmetic, relational, equality and logical expressions. Constants
+// are folded on the way back up the tree, so a constant subexpression
+// emits nothing and never takes a temporary. Both sides have already
+// been emitted, so simplifying never drops a call.
+Operand CompoundExpr::EmitBinary() {
+  Operand leftOperand = left->Emit();
+  Operand rightOperand = right->Emit();
+
+  Operand folded;
+  if (SimplifyOperation(op->GetOperator(), leftOperand, rightOperand, folded)) {
+    return folded;
+  }
 
-  string registerString = "t" + to_string(registerCounter);
-  registerCounter++;
-  
-  // TACObject newTac;
-  // newTac.id = " ";
-  // newTac.line =  string("    ") + registerString + string(" := ") + leftString + string(" ") + opString + string(" ") + rightString;
-  // int typeResult = 1;
-  // for(int i = 0; i < TACContainer.size(); i++){
-  //     std::string eachline = TACContainer[i].line;
-  //     if(eachline.at(0)  != ' '){
-  //         typeResult = 3;
-  //         break;
-  //     }
-  // }
-  // // if var in function, type = 1.
-  // newTac.type = typeResult;
+  Operand registerOperand = NewTemp();
 
-  TACObject newTac ;
-  newTac.type = 12;
+  TACObject newTac;
+  newTac.type = TAC_BinaryOp;
+  newTac.src1 = leftOperand;
+  newTac.src2 = rightOperand;
+  newTac.ops = op->GetOperator();
+  newTac.dst = registerOperand;
+  newTac.declares = 1;
+  AllocateSlot();
+  AppendTAC(newTac);
+
+  return registerOperand;
+}
 
-  newTac.lhs = leftString;
-  newTac.rhs = rightString;
-  newTac.ops = opString;
-  newTac.toCurVar = registerString;
-  newTac.id = registerString;
-  newTac.countedAllocation = 1;
-  TACContainer.push_back(newTac);   
+Operand ArithmeticExpr::Emit() {
+  return EmitBinary();
+}
 
-  return registerString;
+Operand RelationalExpr::Emit() {
+  return EmitBinary();
 }
 
-string AssignExpr::Emit() {
-  string l,r,o;
+Operand AssignExpr::Emit() {
+  Operand l,r;
   if(left){
     l = left->Emit();
   }
   if(right){
     r = right->Emit();
   }
-  if(op){
-    o = op->Emit();
-  }
   TACObject newTac ;
+  newTac.type = TAC_Assign;
+  newTac.dst = l;
+  newTac.src1 = r;
 
-  int checkVarInited = 0;
-  for(int i = 0; i < TACContainer.size(); i++){
-    
-    if(l == TACContainer[i].id){
-      newTac.id = "";
-      newTac.type = 2;
-      newTac.localVarName = l;
-      newTac.localAssignedValue = r;
-
-      //newTac.line =  string("    ") + l + string(" := ") + r;
-      //newTac.type = 0;
-      checkVarInited = 1;
-      break;
-    }
-  }
-  if(checkVarInited == 0){
-    newTac.id = l;
-    newTac.type = 2;
-    newTac.localVarName = l;
-    newTac.localAssignedValue = r;
-    //newTac. = 1;
-    //newTac.line =  string("    ") + l + string(" := ") + r;
-    //newTac.type = 0;
+  // the first assignment to a name in a function declares it
+  if(definedVars.insert(l).second){
+    newTac.declares = 1;
   }
   
-  TACContainer.push_back(newTac); 
+  AppendTAC(newTac);
 
   return l;
 }
 
-string LogicalExpr::Emit() {
-  string l,r,o;
-  if(left){
-    l = left->Emit();
-  }
-  if(right){
-    r = right->Emit();
-  }
-  if(op){
-    o = op->Emit();
-  }
-
-  
-  return l + " " + o + " " + r ; 
+Operand LogicalExpr::Emit() {
+  return EmitBinary();
 }
 
-string EqualityExpr::Emit() {
-  string leftString = left->Emit();
-  string rightString = right->Emit();
-  string opString = op->Emit();
-
-  string registerString = "t" + to_string(registerCounter);
-  registerCounter++;
-  
-  TACObject newTac ;
-  newTac.id = registerString;
-  newTac.type = 12;
-  newTac.countedAllocation = 1;
-  newTac.toCurVar = registerString;
-  newTac.lhs = leftString;
-  newTac.ops = opString;
-  newTac.rhs = rightString;
-
-  //newTac.id = " ";
-  //newTac.line =  string("    ") + registerString + string(" := ") + leftString + string(" ") + opString + string(" ") + rightString;
-  // int typeResult = 1;
-  // for(int i = 0; i < TACContainer.size(); i++){
-  //     std::string eachline = TACContainer[i].line;
-  //     if(eachline.at(0)  != ' '){
-  //         typeResult = 3;
-  //         break;
-  //     }
-  // }
-  // if var in function, type = 1.
-  //newTac.type = typeResult;
-  TACContainer.push_back(newTac);   
-
-  return registerString;
-  
-  //return "EqualityExpr::Emit()"; 
+Operand EqualityExpr::Emit() {
+  return EmitBinary();
 }
 
-string PostfixExpr::Emit() {
-  string l,o;
-  if(op){
-    o = op->Emit();
-  }
-  if(left){
-    l = left->Emit();
-  }
+// `a++` updates a in place: a := a + 1, with no temporary
+Operand PostfixExpr::Emit() {
+  Operand l = left->Emit();
   
   TACObject newTac ;
-  newTac.type = 12;
-
-  string registerString = "t" + to_string(registerCounter);
-  registerCounter++;
-
-  if(o == "++"){
-    newTac.toCurVar = registerString;
-    newTac.lhs = l;
-    newTac.ops = "+";
-    newTac.rhs = "1";
+  newTac.type = TAC_BinaryOp;
+  newTac.dst = l;
+  newTac.src1 = l;
+  newTac.ops = strcmp(op->GetTokenString(), "--") == 0 ? OP_Sub : OP_Add;
+  newTac.src2 = Operand::Int(1);
+  AppendTAC(newTac);
 
-    //newTac.line =  string("    ") + l + string(" := ") + l + " + 1";
-  }
-  else if(o == "--"){
-    newTac.toCurVar = registerString;
-    newTac.lhs = l;
-    newTac.ops = "-";
-    newTac.rhs = "1";
-    //newTac.line =  string("    ") + l + string(" := ") + l + " - 1";
-  }
-  TACContainer.push_back(newTac); 
-
-  TACObject newTac1;
-  newTac1.type = 2;
-  newTac1.localVarName = l;
-  newTac1.localAssignedValue = registerString; 
-  TACContainer.push_back(newTac1);  
-  // int checkVarInited = 0;
-  // for(int i = 0; i < TACContainer.size(); i++){
-  //   //strcmp( l.compare(TACContainer[i].id) == 0
-  //   if(l == TACContainer[i].id){
-  //     checkVarInited = 1;
-  //     break;
-  //   }
-  // }
-  // if(checkVarInited == 0){
-  //   newTac.id = "";
-  //   //newTac.type = 0;
-  // }
-
-
-  
-
-  return "PostfixExpr::Emit()";
+  return l;
 }
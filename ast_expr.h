@@ -43,7 +43,7 @@ class EmptyExpr : public Expr
 {
   public:
     const char *GetPrintNameForNode() { return "Empty"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class IntConstant : public Expr
@@ -56,7 +56,7 @@ class IntConstant : public Expr
     const char *GetPrintNameForNode() { return "IntConstant"; }
     void PrintChildren(int indentLevel);
     int GetValue() { return value; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class BoolConstant : public Expr
@@ -69,19 +69,21 @@ class BoolConstant : public Expr
     const char *GetPrintNameForNode() { return "BoolConstant"; }
     void PrintChildren(int indentLevel);
     bool GetValue() { return value; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class Operator : public Node
 {
   protected:
     char tokenString[4];
+    TACOperator tacOp;
 
   public:
     Operator(yyltype loc, const char *tok);
     const char *GetPrintNameForNode() { return "Operator"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    const char *GetTokenString() { return tokenString; }
+    TACOperator GetOperator() { return tacOp; }
  };
 
 class CompoundExpr : public Expr
@@ -90,6 +92,8 @@ class CompoundExpr : public Expr
     Operator *op;
     Expr *left, *right; // left will be NULL if unary
 
+    Operand EmitBinary();
+
   public:
     CompoundExpr(Expr *lhs, Operator *op, Expr *rhs); // for binary
     CompoundExpr(Operator *op, Expr *rhs);             // for unary
@@ -103,7 +107,7 @@ class ArithmeticExpr : public CompoundExpr
     ArithmeticExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     ArithmeticExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
     const char *GetPrintNameForNode() { return "ArithmeticExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class RelationalExpr : public CompoundExpr
@@ -111,7 +115,7 @@ class RelationalExpr : public CompoundExpr
   public:
     RelationalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     const char *GetPrintNameForNode() { return "RelationalExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class EqualityExpr : public CompoundExpr
@@ -119,7 +123,7 @@ class EqualityExpr : public CompoundExpr
   public:
     EqualityExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     const char *GetPrintNameForNode() { return "EqualityExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class LogicalExpr : public CompoundExpr
@@ -128,7 +132,7 @@ class LogicalExpr : public CompoundExpr
     LogicalExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     LogicalExpr(Operator *op, Expr *rhs) : CompoundExpr(op,rhs) {}
     const char *GetPrintNameForNode() { return "LogicalExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class SelectionExpr : public Expr
@@ -146,7 +150,7 @@ class AssignExpr : public CompoundExpr
   public:
     AssignExpr(Expr *lhs, Operator *op, Expr *rhs) : CompoundExpr(lhs,op,rhs) {}
     const char *GetPrintNameForNode() { return "AssignExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class PostfixExpr : public CompoundExpr
@@ -154,7 +158,7 @@ class PostfixExpr : public CompoundExpr
   public:
     PostfixExpr(Expr *lhs, Operator *op) : CompoundExpr(lhs,op) {}
     const char *GetPrintNameForNode() { return "PostfixExpr"; }
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 /* Like field access, call is used both for qualified base.field()
@@ -173,7 +177,7 @@ class Call : public Expr
     Call(yyltype loc, Expr *base, Identifier *field, List<Expr*> *args);
     const char *GetPrintNameForNode() { return "Call"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class VarExpr : public Expr
@@ -184,8 +188,8 @@ class VarExpr : public Expr
     VarExpr(yyltype loc, Identifier *ident);
     const char *GetPrintNameForNode() { return "VarExpr"; }
     void PrintChildren(int identLevel);
-    string GetName() {return id->GetName();}
-    virtual string Emit();
+    char *GetName() {return id->GetName();}
+    virtual Operand Emit();
 };
 
 #endif
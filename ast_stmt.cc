@@ -6,6 +6,12 @@
 #include "ast_type.h"
 #include "ast_decl.h"
 #include "ast_expr.h"
+#include "output.h"
+#include "cfg.h"
+#include "loops.h"
+#include "passes.h"
+#include "ssa.h"
+#include "utility.h"
 
 
 Program::Program(List<Decl*> *d) {
@@ -82,289 +88,284 @@ void DeclStmt::PrintChildren(int indentLevel) {
 }
 
 // TODO 
-string Program::Emit() {
+Operand Program::Emit() {
     if ( decls->NumElements() > 0 ) {
       for ( int i = 0; i < decls->NumElements(); ++i ) {
         Decl *d = decls->Nth(i);
         d->Emit();
       }
     }
-     //vector<TACObject> optimized_TACContainer = constantFolding(TACContainer);
-     //vector<TACObject> optimized_TACContainer = constantPropogation(TACContainer);
-    //vector<TACObject> optimized_TACContainer = deadCodeElimination(TACContainer);
-    for (int i = 0; i < TACContainer.size(); i++) {
-        TACContainer[i].printByLines();
-        //optimized_TACContainer[i].printByLines();
-    }
-
-
-    // assign beq result (1 or 0) to [if ~ goto branch] tac.
-    // to implement the branch correctly
-    for (int i = 0; i < TACContainer.size(); i++) {
-        if(TACContainer[i].ops == "<="){
-            if(TACContainer[i + 1].type == 10){
-                TACContainer[i + 1].beqResult = 0;
+    RunPasses(functions);
+    ReportTACMemory(functions);
+    ReportCFG(functions);
+    ReportLoops(functions);
+
+    // the TAC is printed as the passes left it, phis and all
+    ostream &out = Output();
+    if (GetEmitMode() & EmitTAC) {
+        for (int f = 0; f < functions.size(); f++) {
+            vector<TACObject> &code = functions[f]->code;
+            for (int i = 0; i < code.size(); i++) {
+                code[i].printByLines();
             }
         }
-        
     }
-    cout << "=================================" << endl;
-    vList = createVarList(TACContainer);
-    
-    cout << ".data" << endl;
-    cout << ".text" << endl;
-
-    // for (int i = 0; i < TACContainer.size(); i++) {
-    //     //TACContainer[i].printMips();
-    //     cout << TACContainer[i].type << endl;
-    // }
-
 
-    for (int i = 0; i < TACContainer.size(); i++) {
-        
-        TACContainer[i].printMips();
+    for (int f = 0; f < functions.size(); f++) {
+        DestroySSA(functions[f]);
+        LayoutFrame(functions[f]);
+    }
+    if (!(GetEmitMode() & EmitMips))
+        return Operand();
+    if (GetEmitMode() & EmitTAC)
+        out << "=================================" << '\n';
+
+    out << ".data" << '\n';
+    if (numGlobalSlots > 0) {
+        out << "_globals: .space " << 4 * numGlobalSlots << '\n';
+    }
+    out << ".text" << '\n';
+
+    // Execution starts at main, so the top-level code that initializes
+    // globals runs first thing in main, right after its prologue
+    int mainName = InternName("main");
+    bool hasMain = false;
+    for (int f = 0; f < functions.size(); f++) {
+        hasMain = hasMain || functions[f]->name == Operand(OPND_Func, mainName);
+    }
+    for (int f = 0; f < functions.size(); f++) {
+        TACFunction *fn = functions[f];
+        if (fn->IsTopLevel() && hasMain)
+            continue;
+        if (fn->name != Operand(OPND_Func, mainName)) {
+            PrintMips(*fn, 0, fn->code.size());
+            continue;
+        }
+        PrintMips(*fn, 0, 1);
+        for (int g = 0; g < functions.size(); g++) {
+            if (functions[g]->IsTopLevel())
+                PrintMips(*functions[g], 0, functions[g]->code.size());
+        }
+        PrintMips(*fn, 1, fn->code.size());
     }
     // cout << "var list:" << endl;
     
-    return "Program::Emit()";
+    return Operand();
 }
 
 //finished ====
-string StmtBlock::Emit() {
+Operand StmtBlock::Emit() {
     for(int i = 0; i < stmts->NumElements(); i++){
         Stmt* ith_statement = stmts->Nth(i);
         ith_statement->Emit();
     }
     
-    return "StmtBlock::Emit()";
+    return Operand();
 }
 
-string ForStmt::Emit() { 
-    string retInit;
+Operand ForStmt::Emit() { 
     if(init){
-        retInit = init -> Emit();
+        init -> Emit();
     }
 
-    string testLabel;
-    string bodyLabel;
-    string endLabel;
+    Operand testLabel;
+    Operand bodyLabel;
+    Operand endLabel;
 
-    testLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    testLabel = NewLabel();
 
-    bodyLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    bodyLabel = NewLabel();
 
-    endLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    endLabel = NewLabel();
     if(test){
 
         TACObject newTac1;
-        newTac1.type = 13;
-        newTac1.label = testLabel;
-        //newTac1.line = testLabel + ":";
+        newTac1.type = TAC_Label;
+        newTac1.src1 = testLabel;
         //newTac1.type = 0;
         //newTac1.id = " ";
-        TACContainer.push_back(newTac1); 
+        AppendTAC(newTac1);
 
-        string res = test->Emit();
+        Operand res = test->Emit();
 
 
         TACObject newTac2;
-        newTac2.conditionVar = res;
-        newTac2.branchVar = bodyLabel;
-        newTac2.type = 10;
-        newTac2.countedAllocation = 1;  // int a; for(a= 2; ~~~)
-        //newTac2.line = string("    if ") + res + " goto " +  bodyLabel;
+        newTac2.src1 = res;
+        newTac2.src2 = bodyLabel;
+        newTac2.type = TAC_IfGoto;
+        AllocateSlot();  // int a; for(a= 2; ~~~)
         //newTac2.type = 1;
         //newTac2.id = " ";
-        TACContainer.push_back(newTac2); 
+        AppendTAC(newTac2);
 
     }
 
     TACObject gotoEnd ;
-    gotoEnd.type = 11;
-    gotoEnd.targetLocation = endLabel;
+    gotoEnd.type = TAC_Goto;
+    gotoEnd.src1 = endLabel;
 
-    //gotoEnd.line = string("    goto ") + endLabel;
     //gotoEnd.type = 0;
     //gotoEnd.id = " ";
-    TACContainer.push_back(gotoEnd); 
+    AppendTAC(gotoEnd);
 
     if(body){
         TACObject newTac1 ;
-        newTac1.type = 13;
-        newTac1.label = bodyLabel;
+        newTac1.type = TAC_Label;
+        newTac1.src1 = bodyLabel;
 
 
-        //newTac1.line = bodyLabel + ":";
         //newTac1.type = 0;
         //newTac1.id = " ";
-        TACContainer.push_back(newTac1); 
+        AppendTAC(newTac1);
         body->Emit();
 
 
 
         step->Emit();
         TACObject gotoEnd1 ;
-        gotoEnd1.type = 11;
-        gotoEnd1.targetLocation = testLabel;
-        gotoEnd1.endOfForLoop = 1;
-        //gotoEnd1.line = string("    goto ") + testLabel;
+        gotoEnd1.type = TAC_Goto;
+        gotoEnd1.src1 = testLabel;
         //gotoEnd1.type = 0;
         //gotoEnd1.id = " ";
-        TACContainer.push_back(gotoEnd1); 
+        AppendTAC(gotoEnd1);
     }
 
 
     TACObject newTac ;
-    newTac.label = endLabel;
-    newTac.type = 13;
+    newTac.src1 = endLabel;
+    newTac.type = TAC_Label;
 
     //newTac.id = " ";
-    TACContainer.push_back(newTac); 
+    AppendTAC(newTac);
 
-    return "ForStmt::Emit()";
+    return Operand();
 }
 
-string WhileStmt::Emit() {
-    string testLabel;
-    string bodyLabel;
-    string endLabel;
+Operand WhileStmt::Emit() {
+    Operand testLabel;
+    Operand bodyLabel;
+    Operand endLabel;
 
-    testLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    testLabel = NewLabel();
 
-    bodyLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    bodyLabel = NewLabel();
 
-    endLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    endLabel = NewLabel();
 
     if(test){
 
         TACObject newTac1 ;
-        newTac1.type = 13;
-        newTac1.label = testLabel;
+        newTac1.type = TAC_Label;
+        newTac1.src1 = testLabel;
         
 
         // TACObject newTac1;
-        // newTac1.line = testLabel + ":";
 
         // newTac1.type = 0;
 
         // newTac1.id = " ";
-        TACContainer.push_back(newTac1); 
+        AppendTAC(newTac1);
 
-        string res = test->Emit();
+        Operand res = test->Emit();
 
         TACObject newTac2 ;
-        newTac2.conditionVar = res;
-        newTac2.branchVar = bodyLabel;
-        newTac2.type = 10;
+        newTac2.src1 = res;
+        newTac2.src2 = bodyLabel;
+        newTac2.type = TAC_IfGoto;
 
 
         // TACObject newTac2;
-        // newTac2.line = string("    if ") + res + " goto " +  bodyLabel;
 
         // newTac2.type = 0;
         // newTac2.id = " ";
-        TACContainer.push_back(newTac2); 
+        AppendTAC(newTac2);
 
 
         TACObject gotoEnd ;
-        gotoEnd.type = 11;
-        gotoEnd.targetLocation = endLabel;
+        gotoEnd.type = TAC_Goto;
+        gotoEnd.src1 = endLabel;
 
         // TACObject gotoEnd;
-        // gotoEnd.line = string("    goto ") + endLabel;
         // gotoEnd.type = 0;
         // gotoEnd.id = " ";
-        TACContainer.push_back(gotoEnd);
+        AppendTAC(gotoEnd);
     }
 
     if(body){
         // TACObject newTac1;
-        // newTac1.line = bodyLabel + ":";
 
         // newTac1.type = 0;
         // newTac1.id = " ";
         // 
         TACObject newTac1 ;
-        newTac1.type = 13;
-        newTac1.label = bodyLabel;
+        newTac1.type = TAC_Label;
+        newTac1.src1 = bodyLabel;
 
-        TACContainer.push_back(newTac1); 
+        AppendTAC(newTac1);
 
         body->Emit();
         // TACObject gotoEnd1;
-        // gotoEnd1.line = string("    goto ") + testLabel;
         // gotoEnd1.type = 0;
         // gotoEnd1.id = " ";
         TACObject gotoEnd1 ;
-        gotoEnd1.type = 11;
-        gotoEnd1.endOfForLoop = 1;
-        gotoEnd1.targetLocation = testLabel;
+        gotoEnd1.type = TAC_Goto;
+        gotoEnd1.src1 = testLabel;
 
-        TACContainer.push_back(gotoEnd1); 
+        AppendTAC(gotoEnd1);
     }
 
     // TACObject newTac;
-    // newTac.line = endLabel + ":";
 
     // newTac.type = 0;
     // newTac.id = " ";
     TACObject newTac ;
-    newTac.label = endLabel;
-    newTac.type = 13;
+    newTac.src1 = endLabel;
+    newTac.type = TAC_Label;
     
 
-    TACContainer.push_back(newTac);  
-    return "WhileStmt";
+    AppendTAC(newTac);
+    return Operand();
 }
 
-string IfStmt::Emit() {
-    string ifLabel;    // 0
-    string endLabel;   //4   
-    string elseLabel;  // 1    after inner-if statement in ifLabel  go to the end of if and then create end label
+Operand IfStmt::Emit() {
+    Operand ifLabel;    // 0
+    Operand endLabel;   //4   
+    Operand elseLabel;  // 1    after inner-if statement in ifLabel  go to the end of if and then create end label
+    int endOfInner = -1;
 
 
-    ifLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    ifLabel = NewLabel();
     if(elseBody){
-        elseLabel = string("L") + std::to_string(labelCounter);
-        labelCounter++;
+        elseLabel = NewLabel();
     }
 
     if(test){
-        string received = test->Emit();
+        Operand received = test->Emit();
         TACObject newTac ;
-        newTac.type = 10;
-        newTac.conditionVar = received;
-        newTac.branchVar = ifLabel;
-        //newTac.line = string("    ") + "if " + received + " goto " + ifLabel;
+        newTac.type = TAC_IfGoto;
+        newTac.src1 = received;
+        newTac.src2 = ifLabel;
 
         //newTac.type = 0;
         //newTac.id = " ";
-        TACContainer.push_back(newTac); 
+        AppendTAC(newTac);
 
         TACObject newTac0 ;
-        newTac0.type = 11; 
+        newTac0.type = TAC_Goto; 
         if(elseBody){
-            // newTac0.line = string("    ") + "goto " + elseLabel;
             // newTac0.type = 0;
             // newTac0.id = " ";
-            newTac0.targetLocation = elseLabel;
-            TACContainer.push_back(newTac0);
+            newTac0.src1 = elseLabel;
+            AppendTAC(newTac0);
         }
         else{
-            string endOfInner = string("L") + std::to_string(labelCounter) ;
+            // jumps to the end label, which is only made after the body
+            // so that the body's own labels come first
+            endOfInner = CurrentFunction()->code.size();
 
-            // newTac0.line = string("    ") + "goto " + endOfInner;
             // newTac0.type = 0;
             // newTac0.id = " ";
-            newTac0.targetLocation = endOfInner;
-            TACContainer.push_back(newTac0);
+            AppendTAC(newTac0);
         }
 
          
@@ -373,13 +374,12 @@ string IfStmt::Emit() {
     if(body){
         
         TACObject newTac;
-        newTac.type = 13;
-        newTac.label = ifLabel;
+        newTac.type = TAC_Label;
+        newTac.src1 = ifLabel;
         
-        // newTac.line = ifLabel + ":";
         // newTac.type = 0;
         // newTac.id = " ";
-        TACContainer.push_back(newTac); 
+        AppendTAC(newTac);
 
         body->Emit();
     }
@@ -387,68 +387,64 @@ string IfStmt::Emit() {
 
     // go to end func
     
-    endLabel = string("L") + std::to_string(labelCounter);
-    labelCounter++;
+    endLabel = NewLabel();
+    if(endOfInner >= 0){
+        CurrentFunction()->code[endOfInner].src1 = endLabel;
+    }
     TACObject newTac;
-    newTac.type = 11;
-    newTac.targetLocation = endLabel;
+    newTac.type = TAC_Goto;
+    newTac.src1 = endLabel;
 
-    // newTac.line = string("    ") +  "goto " + endLabel;
 
     // newTac.type = 0;
     // newTac.id = " ";
-    TACContainer.push_back(newTac); 
+    AppendTAC(newTac);
 
     if(elseBody){
         TACObject newTac;
-        newTac.type = 13;
-        newTac.label = elseLabel;
+        newTac.type = TAC_Label;
+        newTac.src1 = elseLabel;
 
-        // newTac.line = elseLabel + ":";
 
         // newTac.type = 0;
         // newTac.id = " ";
-        TACContainer.push_back(newTac); 
+        AppendTAC(newTac);
         elseBody->Emit();
 
         TACObject endTac ;
-        endTac.type = 11;
-        endTac.targetLocation = endLabel;
-        //endTac.line = string("    ") +  "goto " + endLabel;
+        endTac.type = TAC_Goto;
+        endTac.src1 = endLabel;
         //endTac.id = " ";
-        TACContainer.push_back(endTac); 
+        AppendTAC(endTac);
        
     }
     TACObject endTac1 ;
-    endTac1.type = 13;
-    endTac1.label = endLabel;
-    endTac1.endOfIf = 1;
+    endTac1.type = TAC_Label;
+    endTac1.src1 = endLabel;
 
-    // endTac1.line = endLabel + ":";
     // endTac1.id = " ";
-    TACContainer.push_back(endTac1); 
+    AppendTAC(endTac1);
     
-    return "ifStmt";
+    return Operand();
 }
 
-string ReturnStmt::Emit() {
-    string ret;
+Operand ReturnStmt::Emit() {
+    Operand ret;
     if(expr){
         ret = expr->Emit();
         TACObject newTac ;
-        newTac.type = 9;
-        newTac.returnedString = ret;
-        // newTac.line = string("    ") + "Return" + string(" ") + ret;
+        newTac.type = TAC_Return;
+        newTac.src1 = ret;
         // newTac.type = 4;
         // newTac.id = " ";
-        TACContainer.push_back(newTac); 
+        AppendTAC(newTac);
         
     }
-    return "ReturnStmt Emit()";
+    return Operand();
 }
 
-string DeclStmt::Emit() {
+Operand DeclStmt::Emit() {
     varDecl->Emit();
-    return "DeclStmt Emit()";
+    return Operand();
 }
 
@@ -32,7 +32,7 @@ class Program : public Node
      Program(List<Decl*> *declList);
      const char *GetPrintNameForNode() { return "Program"; }
      void PrintChildren(int indentLevel);
-     virtual string Emit();
+     virtual Operand Emit();
 };
 
 class Stmt : public Node
@@ -51,7 +51,7 @@ class StmtBlock : public Stmt
     StmtBlock(List<Stmt*> *statements);
     const char *GetPrintNameForNode() { return "StmtBlock"; }
     void PrintChildren(int indentLevel);
-    string virtual Emit();
+    virtual Operand Emit();
 };
 
 
@@ -82,7 +82,7 @@ class ForStmt : public LoopStmt
     ForStmt(Expr *init, Expr *test, Expr *step, Stmt *body);
     const char *GetPrintNameForNode() { return "ForStmt"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class WhileStmt : public LoopStmt
@@ -91,7 +91,7 @@ class WhileStmt : public LoopStmt
     WhileStmt(Expr *test, Stmt *body) : LoopStmt(test, body) {}
     const char *GetPrintNameForNode() { return "WhileStmt"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 
@@ -105,7 +105,7 @@ class IfStmt : public ConditionalStmt
     IfStmt(Expr *test, Stmt *thenBody, Stmt *elseBody);
     const char *GetPrintNameForNode() { return "IfStmt"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class IfStmtExprError : public IfStmt
@@ -132,7 +132,7 @@ class ReturnStmt : public Stmt
     ReturnStmt(yyltype loc, Expr *expr);
     const char *GetPrintNameForNode() { return "ReturnStmt"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 class DeclStmt: public Stmt
@@ -144,7 +144,7 @@ class DeclStmt: public Stmt
     DeclStmt(yyltype loc, Decl* decl);
     const char *GetPrintNameForNode() { return "DeclStmt"; }
     void PrintChildren(int indentLevel);
-    virtual string Emit();
+    virtual Operand Emit();
 };
 
 #endif
@@ -0,0 +1,405 @@
+#!/bin/bash
+#
+# Compile-time benchmarks on generated inputs, and the instructions the
+# code compiled at each -O level runs in mipsim.py.
+#
+# Usage: ./bench.sh [scenario ...]
+#   emit   assignments that each need the "already declared" lookup
+#   funcs  many small functions
+#   io     writing a multi-megabyte output, in each emit mode
+#   cfg    building the control-flow graph of code with many labels
+#   dce    liveness and dead code elimination over a large function
+#   lvn    local value numbering over a large block of repeated products
+#   gvn    redundancy elimination over a long run of if/else diamonds
+#   licm   loop-invariant code motion over a long run of nested loops
+#   ivs    induction-variable strength reduction over a long run of loops
+#   scev   closed forms of a long run of summing loops to a bound read in
+#   levels compile time and code size at each -O level
+#   passes time and peak RSS of the -O3 passes on a 500k-instruction main()
+#   ssa    going into SSA form and back out over deeply nested branches
+#   run    instructions executed at -O1, -O2 and -O3, flagging any program
+#          that -O2 makes run more of them than -O1
+#
+# Set PARSER to benchmark a different build of the compiler.
+
+PARSER=${PARSER:-./parser}
+TIMEFORMAT=%R
+
+if [ ! -e $PARSER ]; then
+  echo "But first, running make..."
+  make
+  echo
+fi
+
+input=$(mktemp)
+trap "rm -f $input" EXIT
+
+# main() with n assignments spread over 100 variables. Each variable is
+# first assigned partway through the function, so a lookup that scans
+# earlier TAC has to walk back to that point.
+gen_assign() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    per = int(n / 100); if (per < 1) per = 1;
+    for (i = 0; i < n; i++) {
+      v = int(i / per);
+      if (i % per == 0) print "  v" v " = " i ";";
+      else print "  v" v " = v" v " + 1;";
+    }
+    print "}";
+  }' > $input
+}
+
+# n small functions followed by main()
+gen_funcs() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    for (i = 0; i < n; i++) {
+      print "void f" i "() {";
+      print "  int a = " i ";";
+      print "  int b = a + 1;";
+      print "  a = a * b;";
+      print "}";
+    }
+    print "void main() {";
+    print "}";
+  }' > $input
+}
+
+# straight-line arithmetic over 20 variables, n statements
+gen_straight() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    for (v = 0; v < 20; v++) print "  int v" v " = " v ";";
+    for (i = 0; i < n; i++)
+      print "  v" (i % 20) " = v" ((i + 7) % 20) " + v" ((i + 13) % 20) ";";
+    for (v = 0; v < 20; v++) print "  printInt(v" v ");";
+    print "}";
+  }' > $input
+}
+
+# n statements over 20 variables, each adding a product to the same
+# product with its factors swapped
+gen_repeated() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    for (v = 0; v < 20; v++) print "  int v" v " = " v ";";
+    for (i = 0; i < n; i++) {
+      a = "v" ((i + 7) % 20); b = "v" ((i + 13) % 20);
+      print "  v" (i % 20) " = " a " * " b " + " b " * " a ";";
+    }
+    for (v = 0; v < 20; v++) print "  printInt(v" v ");";
+    print "}";
+  }' > $input
+}
+
+gen_diamonds() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    print "  int x = readIntFromSTDIN();";
+    for (v = 0; v < 20; v++) print "  int p" v " = readIntFromSTDIN();";
+    for (i = 0; i < n; i++) {
+      a = "p" ((i + 7) % 20); b = "p" ((i + 13) % 20);
+      print "  if (x < " i ") { x = " a " * " b " + " i "; } else { x = x + " a " - " b "; }";
+      print "  x = x + " a " * " b ";";
+    }
+    print "  printInt(x);";
+    print "}";
+  }' > $input
+}
+
+gen_loops() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "int total;";
+    print "void main() {";
+    print "  int i;";
+    print "  int j;";
+    print "  int s = 0;";
+    for (v = 0; v < 5; v++) print "  int p" v " = readIntFromSTDIN();";
+    for (l = 0; l < n; l++) {
+      a = "p" (l % 5); b = "p" ((l + 2) % 5);
+      print "  for (i = 0; i < " a "; i = i + 1) {";
+      print "    for (j = 0; j < " b "; j = j + 1) {";
+      print "      s = s + " a " * " b " + i * " b " + j;";
+      print "      total = total + " l ";";
+      print "    }";
+      print "  }";
+    }
+    print "  printInt(s);";
+    print "  printInt(total);";
+    print "}";
+  }' > $input
+}
+
+# main() with n counted loops, each summing its counter times a constant
+gen_counted() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    print "  int i;";
+    print "  int s = 0;";
+    for (l = 0; l < n; l++) {
+      print "  for (i = 0; i < " (l % 50 + 10) "; i = i + 1) {";
+      print "    s = s + i * " (l % 7 + 2) ";";
+      print "  }";
+    }
+    print "  printInt(s);";
+    print "}";
+  }' > $input
+}
+
+# main() with n while loops summing up to a bound read at run time, as
+# in convertResult.s
+gen_sums() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    print "  int n = readIntFromSTDIN();";
+    print "  int i;";
+    print "  int s = 0;";
+    for (l = 0; l < n; l++) {
+      print "  i = " (l % 5) ";";
+      print "  while (i <= n) {";
+      print "    s = s + i * " (l % 7 + 2) " + " (l % 3) ";";
+      print "    i = i + 1;";
+      print "  }";
+    }
+    print "  printInt(s);";
+    print "}";
+  }' > $input
+}
+
+# main() with n if/else statements, i.e. 2n labels
+gen_branches() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    print "  int x = 0;";
+    for (i = 0; i < n; i++) {
+      print "  if (x < " i ") { x = x + 1; } else { x = x - 1; }";
+    }
+    print "}";
+  }' > $input
+}
+
+# main() with n statements in a loop, a third of them dead stores
+gen_dead() {
+  local n=$1
+  awk -v n=$n 'BEGIN {
+    print "void main() {";
+    for (v = 0; v < 20; v++) print "  int v" v " = " v ";";
+    print "  int i = 0;";
+    print "  while (i < 10) {";
+    for (i = 0; i < n; i++) {
+      if (i % 3 == 0) print "    v" (i % 20) " = v" ((i + 7) % 20) " * 2;";
+      print "    v" (i % 20) " = v" ((i + 7) % 20) " + v" ((i + 13) % 20) ";";
+      if (i % 1000 == 999) print "    if (v0 < v1) { v0 = v1; }";
+    }
+    print "    i = i + 1;";
+    print "  }";
+    for (v = 0; v < 20; v++) print "  printInt(v" v ");";
+    print "}";
+  }' > $input
+}
+
+# main() with n groups of if statements nested d deep, each level
+# writing one of 10 variables, followed by a loop
+gen_nested() {
+  local n=$1 d=$2
+  awk -v n=$n -v d=$d 'BEGIN {
+    print "void main() {";
+    for (v = 0; v < 10; v++) print "  int v" v " = " v ";";
+    for (g = 0; g < n; g++) {
+      for (k = 0; k < d; k++) {
+        print "  if (v" (k % 10) " < " (g + k) ") {";
+        print "  v" ((g + k) % 10) " = v" ((g + k + 3) % 10) " + 1;";
+      }
+      for (k = 0; k < d; k++) print "  }";
+      print "  while (v0 < " g ") { v0 = v0 + v1; }";
+    }
+    for (v = 0; v < 10; v++) print "  printInt(v" v ");";
+    print "}";
+  }' > $input
+}
+
+bench_emit() {
+  echo "== emit: assignments -> seconds"
+  for n in 1000 10000 100000 1000000; do
+    gen_assign $n
+    echo -n "$n "
+    { time $PARSER < $input > /dev/null; } 2>&1
+  done
+}
+
+bench_funcs() {
+  echo "== funcs: functions -> seconds"
+  for n in 1000 10000 100000; do
+    gen_funcs $n
+    echo -n "$n "
+    { time $PARSER < $input > /dev/null; } 2>&1
+  done
+}
+
+bench_cfg() {
+  echo "== cfg: if/else statements -> seconds"
+  for n in 10000 50000 100000; do
+    gen_branches $n
+    echo -n "$n "
+    { time $PARSER --emit=tac -d cfg < $input > /dev/null; } 2>&1
+  done
+}
+
+bench_dce() {
+  echo "== dce: statements -> pass time, instructions removed"
+  for n in 10000 100000 500000; do
+    gen_dead $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=dce -d passes < $input | sed -n 's/^+++ (passes): dce: //p'
+  done
+}
+
+bench_lvn() {
+  echo "== lvn: statements -> instructions and temporaries saved, pass time"
+  for n in 10000 100000 500000; do
+    gen_repeated $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=lvn -o /dev/null -d passes lvn < $input |
+      sed -n 's/^.*(lvn): main: .* \([0-9]*\) instructions and \([0-9]*\) temporaries saved/\1 instructions, \2 temporaries, /p; s/^+++ (passes): lvn: \([0-9.]* ms\).*/\1/p' | tr -d '\n'
+    echo
+  done
+}
+
+bench_gvn() {
+  echo "== gvn: diamonds -> operations fully and partially redundant, pass time"
+  for n in 1000 10000 50000; do
+    gen_diamonds $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=ssa,gvn -o /dev/null -d passes gvn < $input |
+      sed -n 's/^.*(gvn): main: \([0-9]*\) operations fully redundant, \([0-9]*\) partially.*/\1 fully, \2 partially, /p; s/^+++ (passes): gvn: \([0-9.]* ms\).*/\1/p' | tr -d '\n'
+    echo
+  done
+}
+
+bench_licm() {
+  echo "== licm: loop nests -> instructions hoisted, globals kept in locals, pass time"
+  for n in 1000 10000 50000; do
+    gen_loops $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=ssa,licm -o /dev/null -d passes licm < $input |
+      sed -n 's/^.*(licm): main: .* \([0-9]*\) globals kept in locals, .* \([0-9]*\) instructions hoisted/\2 hoisted, \1 globals, /p; s/^+++ (passes): licm: \([0-9.]* ms\).*/\1/p' | tr -d '\n'
+    echo
+  done
+}
+
+bench_ivs() {
+  echo "== ivs: counted loops -> multiplies reduced, tests replaced, pass time"
+  for n in 1000 10000 50000; do
+    gen_counted $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=ssa,sccp,ivs -o /dev/null -d passes ivs < $input |
+      sed -n 's/^.*(ivs): main: \([0-9]*\) multiplies reduced, \([0-9]*\) tests replaced.*/\1 reduced, \2 replaced, /p; s/^+++ (passes): ivs: \([0-9.]* ms\).*/\1/p' | tr -d '\n'
+    echo
+  done
+}
+
+bench_scev() {
+  echo "== scev: summing loops -> loops evaluated, pass time"
+  for n in 1000 10000 50000; do
+    gen_sums $n
+    echo -n "$n "
+    $PARSER --emit=tac --passes=ssa,scev -o /dev/null -d passes scev < $input |
+      sed -n 's/^.*(scev): main: \([0-9]*\) loops evaluated.*/\1 evaluated, /p; s/^+++ (passes): scev: \([0-9.]* ms\).*/\1/p' | tr -d '\n'
+    echo
+  done
+}
+
+bench_passes() {
+  gen_dead 190000
+  echo "== passes: -O3 on $($PARSER --emit=tac < $input | grep -c '^    ') instructions"
+  $PARSER -O3 --emit=tac -o /dev/null -d passes < $input | sed 's/^+++ (passes): //'
+}
+
+bench_ssa() {
+  echo "== ssa: groups of 10 nested ifs -> phis, into SSA, compile seconds with and without"
+  for n in 1000 10000 20000; do
+    gen_nested $n 10
+    echo -n "$n "
+    $PARSER --passes=ssa -o /dev/null -d passes ssa < $input |
+      sed -n 's/^.*(ssa): main: .* \([0-9]*\) phis placed/\1 phis, /p; s/^+++ (passes): ssa: \([0-9.]* ms\).*/\1, /p' | tr -d '\n'
+    { time $PARSER --passes=ssa -o /dev/null < $input; } 2>&1 | tr '\n' ' '
+    { time $PARSER -o /dev/null < $input; } 2>&1
+  done
+}
+
+bench_levels() {
+  gen_dead 100000
+  echo "== levels: 100000 statements -> seconds, instructions left"
+  for level in 0 1 2 3; do
+    echo -n "-O$level "
+    { time $PARSER -O$level --emit=mips -o /dev/null < $input; } 2>&1 | tr '\n' ' '
+    $PARSER -O$level --emit=tac < $input | grep -c '^    '
+  done
+}
+
+# Runs $input compiled at -O1, -O2 and -O3 in mipsim.py with the given
+# integers as input, printing how many instructions each executes
+run_levels() {
+  local name=$1 mips=$(mktemp)
+  shift
+  local counts=()
+  echo -n "$name"
+  for level in 1 2 3; do
+    $PARSER -O$level --emit=mips -o $mips < $input
+    counts[$level]=$(python3 mipsim.py $mips "$@" 2>&1 > /dev/null | sed 's/^#insns //')
+    echo -n ", -O$level ${counts[$level]}"
+  done
+  if (( ${counts[2]} > ${counts[1]} )); then
+    echo -n "  -O2 SLOWER THAN -O1"
+  fi
+  echo
+  rm -f $mips
+}
+
+bench_run() {
+  echo "== run: program -> instructions executed at each -O level"
+  cp test3.java $input
+  run_levels "test3.java, 1 trip" 1
+  run_levels "test3.java, 100 trips" 100
+  gen_sums 20
+  run_levels "20 summing loops, 10 trips" 10
+  gen_counted 20
+  run_levels "20 counted loops"
+  gen_loops 20
+  run_levels "20 loop nests over globals" 3 4 2 5 3
+  gen_loops 20
+  run_levels "20 loop nests, 1 trip each" 1 1 1 1 1
+  gen_diamonds 200
+  run_levels "200 diamonds" $(seq 1 21)
+  gen_nested 20 4
+  run_levels "20 groups of 4 nested ifs"
+}
+
+# The output goes to a real file so the cost of writing it is included
+bench_io() {
+  local output=$(mktemp)
+  gen_straight 200000
+  $PARSER < $input > $output
+  echo "== io: $(( $(wc -c < $output) / 1048576 )) MB of output -> seconds"
+  echo -n "stdout, both "
+  { time $PARSER < $input > $output; } 2>&1
+  for mode in both tac mips; do
+    echo -n "-o, $mode "
+    { time $PARSER --emit=$mode -o $output < $input; } 2>&1
+  done
+  rm -f $output
+}
+
+scenarios=${@:-emit funcs io cfg dce lvn gvn licm ivs scev levels passes ssa run}
+for s in $scenarios; do
+  bench_$s
+done
@@ -0,0 +1,86 @@
+/* File: cfg.cc
+ * ------------
+ * Construction of the control-flow graph.
+ */
+
+#include "cfg.h"
+#include "utility.h"
+#include <algorithm>
+
+// Lines after which control never falls through to the next line
+static bool endsBlock(const TACObject &t) {
+    return t.type == TAC_Goto || t.type == TAC_IfGoto ||
+           t.type == TAC_Return || t.type == TAC_EndFunc;
+}
+
+CFG::CFG(const vector<TACObject> &code) : blockOf(code.size()) {
+    for (int i = 0; i < code.size(); i++) {
+        bool leader = i == 0 || code[i].type == TAC_Label || endsBlock(code[i - 1]);
+        if (leader) {
+            blocks.push_back(BasicBlock(i));
+            if (code[i].type == TAC_Label)
+                labelBlocks[code[i].src1.value] = blocks.size() - 1;
+        }
+        blockOf[i] = blocks.size() - 1;
+        blocks.back().end = i + 1;
+    }
+
+    for (int b = 0; b < blocks.size(); b++) {
+        const TACObject &last = code[blocks[b].end - 1];
+        int target = -1;
+        if (last.type == TAC_Goto)
+            target = BlockForLabel(last.src1);
+        else if (last.type == TAC_IfGoto)
+            target = BlockForLabel(last.src2);
+        bool fallsThrough = last.type != TAC_Goto && last.type != TAC_Return &&
+                            last.type != TAC_EndFunc && b + 1 < blocks.size();
+
+        if (target >= 0)
+            blocks[b].succs.push_back(target);
+        if (fallsThrough && target != b + 1)
+            blocks[b].succs.push_back(b + 1);
+        for (int s = 0; s < blocks[b].succs.size(); s++)
+            blocks[blocks[b].succs[s]].preds.push_back(b);
+    }
+}
+
+int CFG::BlockForLabel(const Operand &label) const {
+    unordered_map<int, int>::const_iterator it = labelBlocks.find(label.value);
+    return it == labelBlocks.end() ? -1 : it->second;
+}
+
+int CFG::PredIndex(int b, int pred) const {
+    const vector<int> &preds = blocks[b].preds;
+    return find(preds.begin(), preds.end(), pred) - preds.begin();
+}
+
+int CFG::NumEdges() const {
+    int n = 0;
+    for (int b = 0; b < blocks.size(); b++)
+        n += blocks[b].succs.size();
+    return n;
+}
+
+int TopOf(const vector<TACObject> &code, const BasicBlock &block) {
+    int at = block.begin;
+    while (at < block.end && (code[at].type == TAC_Label || code[at].type == TAC_Phi))
+        at++;
+    return at;
+}
+
+int EndOf(const vector<TACObject> &code, const BasicBlock &block) {
+    int type = code[block.end - 1].type;
+    return type == TAC_Goto || type == TAC_IfGoto ? block.end - 1 : block.end;
+}
+
+void ReportCFG(const vector<TACFunction*> &functions) {
+    if (!IsDebugOn("cfg"))
+        return;
+    for (int f = 0; f < functions.size(); f++) {
+        if (functions[f]->IsTopLevel() || functions[f]->code.empty())
+            continue;
+        CFG cfg(functions[f]->code);
+        PrintDebug("cfg", "%s: %d blocks, %d edges", NameOf(functions[f]->name.value).c_str(),
+                   cfg.NumBlocks(), cfg.NumEdges());
+    }
+}
@@ -0,0 +1,62 @@
+/* File: cfg.h
+ * -----------
+ * The control-flow graph of one function's TAC. The code is split into
+ * basic blocks at labels and after jumps and returns; each block knows
+ * the range of instructions it covers and its successor and predecessor
+ * blocks. Blocks are numbered in code order, so block 0 is the entry.
+ *
+ * Building the graph is a single pass over the code plus one hash
+ * lookup per jump, so it stays linear however many labels there are.
+ */
+
+#ifndef _H_cfg
+#define _H_cfg
+
+#include "tac.h"
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+struct BasicBlock {
+    int begin, end;             // instructions [begin, end) of the code
+    vector<int> succs;          // successor block ids
+    vector<int> preds;          // predecessor block ids
+
+    BasicBlock(int b) : begin(b), end(b) {}
+};
+
+class CFG {
+  public:
+    vector<BasicBlock> blocks;
+    vector<int> blockOf;        // block id of each instruction
+
+    CFG(const vector<TACObject> &code);
+
+    int NumBlocks() const { return blocks.size(); }
+    // The block a label starts, or -1 if the label is not in this code
+    int BlockForLabel(const Operand &label) const;
+    int NumEdges() const;
+    // Position of pred in the predecessors of block b, which is also the
+    // position of its argument in the phis of b
+    int PredIndex(int b, int pred) const;
+
+  private:
+    unordered_map<int, int> labelBlocks;
+};
+
+/* Function: TopOf, EndOf
+ * -----------------------
+ * Where code put at the top of a block goes, after its label and phis,
+ * and where code put at its end goes, before the jump ending it.
+ */
+int TopOf(const vector<TACObject> &code, const BasicBlock &block);
+int EndOf(const vector<TACObject> &code, const BasicBlock &block);
+
+/* Function: ReportCFG
+ * -------------------
+ * Builds the graph of every function and prints (under the "cfg" debug
+ * key) its number of blocks and edges.
+ */
+void ReportCFG(const vector<TACFunction*> &functions);
+
+#endif
@@ -0,0 +1,246 @@
+/* File: defuse.cc
+ * ---------------
+ * Implementation of the def-use chains.
+ */
+
+#include "defuse.h"
+#include "liveness.h"
+#include <algorithm>
+
+static bool IsTracked(const Operand &o) {
+    return o.IsValue() && !o.IsGlobal();
+}
+
+DefUse::DefUse(vector<TACObject> &c)
+    : code(c), src1At(c.size(), -1), src2At(c.size(), -1), defAt(c.size(), -1) {
+    // counting first lets every chain start out with the room it needs
+    for (int i = 0; i < code.size(); i++) {
+        const TACObject &t = code[i];
+        if (t.deadMarked)
+            continue;
+        if (IsTracked(t.src1))
+            uses[AddValue(t.src1)].room++;
+        if (IsTracked(t.src2))
+            uses[AddValue(t.src2)].room++;
+        if (t.type == TAC_Phi) {
+            const vector<Operand> &args = PhiArgs(t);
+            for (int k = 0; k < args.size(); k++) {
+                if (IsTracked(args[k]))
+                    uses[AddValue(args[k])].room++;
+            }
+        }
+        if (DefinesValue(t) && IsTracked(t.dst))
+            defs[AddValue(t.dst)].room++;
+    }
+    int size = 0;
+    for (int id = 0; id < defs.size(); id++) {
+        defs[id].begin = size;
+        size += defs[id].room;
+        uses[id].begin = size;
+        size += uses[id].room;
+    }
+    arena.resize(size);
+    for (int i = 0; i < code.size(); i++)
+        Link(i);
+}
+
+int DefUse::IdOf(const Operand &v) const {
+    return IsTracked(v) && v.slot < defs.size() ? v.slot : -1;
+}
+
+int DefUse::AddValue(const Operand &v) {
+    if (v.slot >= defs.size()) {
+        defs.resize(v.slot + 1);
+        uses.resize(v.slot + 1);
+    }
+    return v.slot;
+}
+
+int DefUse::NumDefs(const Operand &v) const {
+    int id = IdOf(v);
+    return id < 0 ? 0 : defs[id].size;
+}
+
+int DefUse::DefAt(const Operand &v, int k) const {
+    return arena[defs[IdOf(v)].begin + k].instr;
+}
+
+int DefUse::NumUses(const Operand &v) const {
+    int id = IdOf(v);
+    return id < 0 ? 0 : uses[id].size;
+}
+
+const Use &DefUse::UseAt(const Operand &v, int k) const {
+    return arena[uses[IdOf(v)].begin + k];
+}
+
+Operand &DefUse::OperandOf(const Use &u) {
+    TACObject &t = code[u.instr];
+    if (u.operand == 0)
+        return t.src1;
+    if (u.operand == 1)
+        return t.src2;
+    return PhiArgs(t)[u.operand - 2];
+}
+
+int &DefUse::PositionOf(const Use &u) {
+    if (u.operand == 0)
+        return src1At[u.instr];
+    if (u.operand == 1)
+        return src2At[u.instr];
+    return phiArgsAt[u.instr][u.operand - 2];
+}
+
+// Adds u at the end of the chain, returning its position there
+int DefUse::Append(Chain &chain, const Use &u) {
+    if (chain.size == chain.room) {
+        int begin = arena.size();
+        chain.room = 2 * chain.room + 1;
+        arena.resize(begin + chain.room);
+        copy(arena.begin() + chain.begin, arena.begin() + chain.begin + chain.size,
+             arena.begin() + begin);
+        chain.begin = begin;
+    }
+    arena[chain.begin + chain.size] = u;
+    return chain.size++;
+}
+
+void DefUse::AddUse(const Operand &v, const Use &u) {
+    int id = AddValue(v);
+    PositionOf(u) = Append(uses[id], u);
+}
+
+// The last use in the chain takes the place of the one removed
+void DefUse::RemoveUse(const Operand &v, const Use &u) {
+    Chain &chain = uses[IdOf(v)];
+    int &at = PositionOf(u);
+    arena[chain.begin + at] = arena[chain.begin + chain.size - 1];
+    PositionOf(arena[chain.begin + at]) = at;
+    chain.size--;
+    at = -1;
+}
+
+void DefUse::Link(int i) {
+    const TACObject &t = code[i];
+    if (t.deadMarked)
+        return;
+    if (IsTracked(t.src1))
+        AddUse(t.src1, Use(i, 0));
+    if (IsTracked(t.src2))
+        AddUse(t.src2, Use(i, 1));
+    if (t.type == TAC_Phi) {
+        const vector<Operand> &args = PhiArgs(t);
+        phiArgsAt[i].assign(args.size(), -1);
+        for (int k = 0; k < args.size(); k++) {
+            if (IsTracked(args[k]))
+                AddUse(args[k], Use(i, 2 + k));
+        }
+    }
+    if (DefinesValue(t) && IsTracked(t.dst)) {
+        int id = AddValue(t.dst);
+        defAt[i] = Append(defs[id], Use(i));
+    }
+}
+
+void DefUse::Unlink(int i) {
+    const TACObject &t = code[i];
+    if (IsTracked(t.src1))
+        RemoveUse(t.src1, Use(i, 0));
+    if (IsTracked(t.src2))
+        RemoveUse(t.src2, Use(i, 1));
+    if (t.type == TAC_Phi) {
+        const vector<Operand> &args = PhiArgs(t);
+        for (int k = 0; k < args.size(); k++) {
+            if (IsTracked(args[k]))
+                RemoveUse(args[k], Use(i, 2 + k));
+        }
+        phiArgsAt.erase(i);
+    }
+    if (DefinesValue(t) && IsTracked(t.dst)) {
+        Chain &chain = defs[IdOf(t.dst)];
+        int at = defAt[i];
+        arena[chain.begin + at] = arena[chain.begin + chain.size - 1];
+        defAt[arena[chain.begin + at].instr] = at;
+        chain.size--;
+        defAt[i] = -1;
+    }
+}
+
+void DefUse::ReplaceAllUsesWith(const Operand &v, const Operand &with) {
+    int id = IdOf(v);
+    if (id < 0 || with == v)
+        return;
+    vector<Use> moved(arena.begin() + uses[id].begin,
+                      arena.begin() + uses[id].begin + uses[id].size);
+    uses[id].size = 0;
+    for (int u = 0; u < moved.size(); u++) {
+        OperandOf(moved[u]) = with;
+        if (IsTracked(with))
+            AddUse(with, moved[u]);
+    }
+}
+
+void DefUse::Replace(int i, const TACObject &t) {
+    Unlink(i);
+    code[i] = t;
+    Link(i);
+}
+
+void DefUse::Erase(int i) {
+    if (code[i].deadMarked)
+        return;
+    Unlink(i);
+    code[i].deadMarked = 1;
+}
+
+int DefUse::Compact() {
+    vector<int> newIndex(code.size());
+    int kept = 0;
+    for (int i = 0; i < code.size(); i++)
+        newIndex[i] = code[i].deadMarked ? -1 : kept++;
+    if (kept == code.size())
+        return 0;
+
+    for (int id = 0; id < defs.size(); id++) {
+        for (int d = 0; d < defs[id].size; d++) {
+            Use &def = arena[defs[id].begin + d];
+            def.instr = newIndex[def.instr];
+        }
+        for (int u = 0; u < uses[id].size; u++) {
+            Use &use = arena[uses[id].begin + u];
+            use.instr = newIndex[use.instr];
+        }
+    }
+    for (int i = 0; i < code.size(); i++) {
+        if (newIndex[i] < 0 || newIndex[i] == i)
+            continue;
+        src1At[newIndex[i]] = src1At[i];
+        src2At[newIndex[i]] = src2At[i];
+        defAt[newIndex[i]] = defAt[i];
+    }
+    src1At.resize(kept);
+    src2At.resize(kept);
+    defAt.resize(kept);
+    unordered_map<int, vector<int> > moved;
+    for (unordered_map<int, vector<int> >::iterator it = phiArgsAt.begin(); it != phiArgsAt.end(); ++it)
+        moved[newIndex[it->first]].swap(it->second);
+    phiArgsAt.swap(moved);
+    return RemoveDeadMarked(code);
+}
+
+bool DominatesUses(const DefUse &chains, const CFG &cfg, const Dominators &dom, const Operand &v) {
+    int def = chains.DefAt(v, 0);
+    int defBlock = cfg.blockOf[def];
+    for (int k = 0; k < chains.NumUses(v); k++) {
+        const Use &use = chains.UseAt(v, k);
+        int b = cfg.blockOf[use.instr];
+        if (use.operand >= 2) {
+            if (!dom.Dominates(defBlock, cfg.blocks[b].preds[use.operand - 2]))
+                return false;
+        }
+        else if (b == defBlock ? use.instr <= def : !dom.Dominates(defBlock, b)) {
+            return false;
+        }
+    }
+    return true;
+}
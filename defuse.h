@@ -0,0 +1,99 @@
+/* File: defuse.h
+ * --------------
+ * Def-use chains of one function's TAC: for every value, the
+ * instructions writing it and the operands reading it.
+ *
+ * The chains are built by one scan of the code and from then on kept up
+ * to date by the changes made through them, so replacing every read of a
+ * value costs time in proportion to its reads, and deleting an
+ * instruction in proportion to its operands, rather than to the size of
+ * the function. Instructions are named by their position in the code.
+ * Deleting one only marks it, as everywhere else, and Compact() then
+ * sweeps the marked instructions out and renumbers the chains in the same
+ * pass over the code.
+ *
+ * A read is whatever UsesOf() counts as one, plus the arguments of a
+ * phi. Values are told apart by their frame slot, which also numbers
+ * the chains densely. Globals, which any call may read or write, have no
+ * chains. Changing the code behind the chains' back, other than through
+ * them, leaves them stale, and they must be thrown away.
+ */
+
+#ifndef _H_defuse
+#define _H_defuse
+
+#include "tac.h"
+#include "cfg.h"
+#include "dominators.h"
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+struct Use {
+    int instr;
+    int operand;                // 0 for src1, 1 for src2, 2 + k for
+                                // argument k of a phi
+
+    Use(int i = -1, int k = 0) : instr(i), operand(k) {}
+};
+
+class DefUse {
+  public:
+    DefUse(vector<TACObject> &code);
+
+    // The instructions writing v and the operands reading it, in no
+    // particular order; none for a global
+    int NumDefs(const Operand &v) const;
+    int DefAt(const Operand &v, int k) const;
+    int NumUses(const Operand &v) const;
+    const Use &UseAt(const Operand &v, int k) const;
+
+    // The operand a use refers to
+    Operand &OperandOf(const Use &u);
+
+    // Makes every read of v read with instead
+    void ReplaceAllUsesWith(const Operand &v, const Operand &with);
+    // Overwrites instruction i, relinking its operands
+    void Replace(int i, const TACObject &t);
+    // Marks instruction i dead and unlinks it
+    void Erase(int i);
+    // Removes the instructions marked dead, returning how many
+    int Compact();
+
+  private:
+    // The chains of all the values are packed into one array, each with
+    // room for what it held when the code was scanned; one that outgrows
+    // its room moves to the end with twice as much. A def is kept as a
+    // use of the destination.
+    struct Chain {
+        int begin, size, room;
+
+        Chain() : begin(0), size(0), room(0) {}
+    };
+    vector<TACObject> &code;
+    vector<Use> arena;
+    vector<Chain> defs, uses;           // by slot
+    // where each instruction's operands sit in their chains, so that one
+    // comes out without a search
+    vector<int> src1At, src2At, defAt;
+    unordered_map<int, vector<int> > phiArgsAt;   // by instruction
+
+    int IdOf(const Operand &v) const;
+    int AddValue(const Operand &v);
+    int &PositionOf(const Use &u);
+    int Append(Chain &chain, const Use &u);
+    void AddUse(const Operand &v, const Use &u);
+    void RemoveUse(const Operand &v, const Use &u);
+    void Link(int i);
+    void Unlink(int i);
+};
+
+/* Function: DominatesUses
+ * -----------------------
+ * Whether the one instruction writing v is on every path to every read
+ * of it, and before the read in a block they share. A phi reads its
+ * argument at the end of the predecessor it comes from.
+ */
+bool DominatesUses(const DefUse &chains, const CFG &cfg, const Dominators &dom, const Operand &v);
+
+#endif
@@ -0,0 +1,114 @@
+/* File: dominators.cc
+ * -------------------
+ * Implementation of the dominator computation.
+ */
+
+#include "dominators.h"
+
+Dominators::Dominators(const CFG &cfg)
+    : idom(cfg.NumBlocks(), -1), children(cfg.NumBlocks()),
+      postorderNumber(cfg.NumBlocks(), -1) {
+    int n = cfg.NumBlocks();
+    if (n == 0)
+        return;
+
+    // depth-first postorder from the entry, without recursion so deeply
+    // nested code can't overflow the stack
+    vector<int> postorder;
+    vector<int> stack(1, 0), nextSucc(n, 0);
+    vector<bool> visited(n, false);
+    visited[0] = true;
+    while (!stack.empty()) {
+        int b = stack.back();
+        if (nextSucc[b] < cfg.blocks[b].succs.size()) {
+            int s = cfg.blocks[b].succs[nextSucc[b]++];
+            if (!visited[s]) {
+                visited[s] = true;
+                stack.push_back(s);
+            }
+        }
+        else {
+            postorderNumber[b] = postorder.size();
+            postorder.push_back(b);
+            stack.pop_back();
+        }
+    }
+    reversePostorder.assign(postorder.rbegin(), postorder.rend());
+
+    idom[0] = 0;
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (int k = 1; k < reversePostorder.size(); k++) {
+            int b = reversePostorder[k];
+            int newIdom = -1;
+            for (int p = 0; p < cfg.blocks[b].preds.size(); p++) {
+                int pred = cfg.blocks[b].preds[p];
+                if (idom[pred] < 0)
+                    continue;
+                newIdom = newIdom < 0 ? pred : Intersect(pred, newIdom);
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    // number the dominator tree in preorder, again without recursion
+    for (int k = 1; k < reversePostorder.size(); k++)
+        children[idom[reversePostorder[k]]].push_back(reversePostorder[k]);
+    preorder.assign(n, -1);
+    lastDominated.assign(n, -1);
+    int number = 0;
+    vector<int> nextChild(n, 0);
+    stack.assign(1, 0);
+    preorder[0] = number++;
+    while (!stack.empty()) {
+        int b = stack.back();
+        if (nextChild[b] < children[b].size()) {
+            int c = children[b][nextChild[b]++];
+            preorder[c] = number++;
+            stack.push_back(c);
+        }
+        else {
+            lastDominated[b] = number - 1;
+            stack.pop_back();
+        }
+    }
+}
+
+int Dominators::Intersect(int a, int b) const {
+    while (a != b) {
+        while (postorderNumber[a] < postorderNumber[b])
+            a = idom[a];
+        while (postorderNumber[b] < postorderNumber[a])
+            b = idom[b];
+    }
+    return a;
+}
+
+bool Dominators::Dominates(int a, int b) const {
+    if (!IsReachable(a) || !IsReachable(b))
+        return false;
+    return preorder[a] <= preorder[b] && preorder[b] <= lastDominated[a];
+}
+
+vector<vector<int> > Dominators::Frontiers(const CFG &cfg) const {
+    vector<vector<int> > frontiers(cfg.NumBlocks());
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        const vector<int> &preds = cfg.blocks[b].preds;
+        if (preds.size() < 2 || !IsReachable(b))
+            continue;
+        for (int p = 0; p < preds.size(); p++) {
+            int runner = preds[p];
+            if (!IsReachable(runner))
+                continue;
+            while (runner != idom[b]) {
+                if (frontiers[runner].empty() || frontiers[runner].back() != b)
+                    frontiers[runner].push_back(b);
+                runner = idom[runner];
+            }
+        }
+    }
+    return frontiers;
+}
@@ -0,0 +1,50 @@
+/* File: dominators.h
+ * ------------------
+ * Dominators of the blocks of a CFG, by the iterative algorithm of
+ * Cooper, Harvey and Kennedy: immediate dominators are refined in reverse
+ * postorder, meeting the predecessors' dominator tree paths, until they
+ * stop changing. On the reducible graphs our statements produce that
+ * takes two sweeps.
+ *
+ * Blocks that cannot be reached from the entry have no dominator and are
+ * left out of everything else.
+ */
+
+#ifndef _H_dominators
+#define _H_dominators
+
+#include "cfg.h"
+#include <vector>
+using namespace std;
+
+class Dominators {
+  public:
+    vector<int> idom;           // immediate dominator, the entry's is
+                                // itself, -1 for unreachable blocks
+    vector<vector<int> > children;  // the dominator tree
+    vector<int> reversePostorder;
+
+    Dominators(const CFG &cfg);
+
+    bool IsReachable(int b) const { return idom[b] >= 0; }
+    // Whether a dominates b; every block dominates itself. Constant time:
+    // the blocks a dominates are numbered right after it in a preorder
+    // walk of the dominator tree
+    bool Dominates(int a, int b) const;
+
+    /* Function: Frontiers
+     * -------------------
+     * The dominance frontier of every block: the blocks where its
+     * dominance ends, i.e. that it doesn't strictly dominate but does
+     * dominate a predecessor of.
+     */
+    vector<vector<int> > Frontiers(const CFG &cfg) const;
+
+  private:
+    vector<int> postorderNumber;
+    vector<int> preorder, lastDominated;    // numbers in the tree walk
+
+    int Intersect(int a, int b) const;
+};
+
+#endif
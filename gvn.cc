@@ -0,0 +1,376 @@
+/* File: gvn.cc
+ * ------------
+ * Implementation of global value numbering and partial redundancy
+ * elimination.
+ */
+
+#include "gvn.h"
+#include "ssa.h"
+#include "liveness.h"
+#include "utility.h"
+#include <algorithm>
+#include <unordered_map>
+
+// An operation on value numbers
+struct Expression {
+    int op;
+    Operand left, right;
+
+    Expression(int o = OP_None, const Operand &l = Operand(), const Operand &r = Operand());
+    bool operator==(const Expression &e) const
+        { return op == e.op && left == e.left && right == e.right; }
+};
+
+// The operands of a commutative operator go in one order
+Expression::Expression(int o, const Operand &l, const Operand &r) : op(o), left(l), right(r) {
+    if (right < left && SwappedOperator(op) != OP_None) {
+        swap(left, right);
+        op = SwappedOperator(op);
+    }
+}
+
+struct ExpressionHash {
+    size_t operator()(const Expression &e) const {
+        OperandHash hash;
+        return ((hash(e.left) * 1000003) ^ hash(e.right)) * 16 + e.op;
+    }
+};
+
+typedef unordered_map<Operand, vector<Operand>, OperandHash> PhiArgsByDst;
+
+class RedundancyElimination {
+  public:
+    int fullyRedundant, partiallyRedundant, copiesPlaced, phisPlaced;
+
+    RedundancyElimination(TACFunction *fn, AnalysisManager &analyses);
+    void Run();
+    // Puts the copies and phis Run() decided on into the code
+    void Apply();
+
+  private:
+    TACFunction *fn;
+    vector<TACObject> &code;
+    const CFG &cfg;
+    const Dominators &dom;
+    const LoopInfo &loops;
+    DefUse &chains;
+    AnalysisManager &analyses;
+    vector<int> pressure;               // by block, once needed
+    vector<signed char> stable;         // by slot, -1 until known
+    unordered_map<Operand, Operand, OperandHash> numberOf;     // of copies
+    // the blocks an operation was computed in so far, in the order of
+    // the walk, each with the value holding the result
+    unordered_map<Expression, vector<pair<int, Operand> >, ExpressionHash> computed;
+    // values written by the copies and phis to be placed, and where
+    unordered_map<Operand, int, OperandHash> newValues;
+    Insertions copies;
+    vector<pair<int, TACObject> > phis;
+    // the last block a value is kept in a register through so far
+    unordered_map<Operand, int, OperandHash> keptUntil;
+
+    bool IsStable(const Operand &o);
+    Operand NumberOf(const Operand &o);
+    int BlockOf(const Operand &v);
+    bool IsAvailableAt(const Operand &v, int b);
+    int LastRead(const Operand &v);
+    bool KeepUntil(const Operand &v, int b);
+    bool OnlyCopied(int i);
+    Operand Available(const Expression &e, int b);
+    bool Translate(const Operand &o, int b, int k, const PhiArgsByDst &phiArgs, Operand &result);
+    bool Merge(int i, const Expression &e, int b, PhiArgsByDst &phiArgs);
+    void Visit(int b);
+};
+
+RedundancyElimination::RedundancyElimination(TACFunction *fn, AnalysisManager &analyses)
+    : fullyRedundant(0), partiallyRedundant(0), copiesPlaced(0), phisPlaced(0),
+      fn(fn), code(fn->code), cfg(analyses.GetCFG()), dom(analyses.GetDominators()),
+      loops(analyses.GetLoops()), chains(analyses.GetDefUse()), analyses(analyses) {}
+
+// Whether o holds the same value wherever it is read: a constant, a
+// value never written, or one written once before any read of it
+bool RedundancyElimination::IsStable(const Operand &o) {
+    if (o.IsConstant())
+        return true;
+    if (!o.IsValue() || o.IsGlobal())
+        return false;
+    if (newValues.count(o) > 0)
+        return true;
+    if (o.slot >= stable.size())
+        stable.resize(o.slot + 1, -1);
+    if (stable[o.slot] < 0) {
+        int defs = chains.NumDefs(o);
+        stable[o.slot] = defs == 0 || (defs == 1 && DominatesUses(chains, cfg, dom, o));
+    }
+    return stable[o.slot];
+}
+
+// The value number of a stable operand: what it is a copy of, if anything
+Operand RedundancyElimination::NumberOf(const Operand &o) {
+    unordered_map<Operand, Operand, OperandHash>::iterator it = numberOf.find(o);
+    return it == numberOf.end() ? o : it->second;
+}
+
+// The block writing a stable value, -1 if none does
+int RedundancyElimination::BlockOf(const Operand &v) {
+    if (v.IsConstant())
+        return -1;
+    unordered_map<Operand, int, OperandHash>::iterator it = newValues.find(v);
+    if (it != newValues.end())
+        return it->second;
+    return chains.NumDefs(v) == 1 ? cfg.blockOf[chains.DefAt(v, 0)] : -1;
+}
+
+// Whether a stable value can be read at the end of block b
+bool RedundancyElimination::IsAvailableAt(const Operand &v, int b) {
+    int def = BlockOf(v);
+    return def < 0 || dom.Dominates(def, b);
+}
+
+// The last block in code order that reads v; a phi reads its arguments
+// at the ends of its predecessors
+int RedundancyElimination::LastRead(const Operand &v) {
+    int last = -1;
+    for (int k = 0; k < chains.NumUses(v); k++) {
+        const Use &u = chains.UseAt(v, k);
+        int b = cfg.blockOf[u.instr];
+        if (code[u.instr].type == TAC_Phi)
+            b = cfg.blocks[b].preds[u.operand - 2];
+        last = max(last, b);
+    }
+    return last;
+}
+
+// Whether stable value v can still be read in block b. The backend
+// keeps it in a register from the block writing it on to there, and all
+// through the loops around b that don't write it, so a phi or copy
+// reading it there only pays if there is a register to spare all that
+// way.
+bool RedundancyElimination::KeepUntil(const Operand &v, int b) {
+    int def = BlockOf(v);
+    if (def < 0)
+        return true;
+    for (int l = loops.LoopOf(b); l >= 0 && !loops.Contains(l, def); l = loops.loops[l].parent)
+        b = max(b, loops.loops[l].blocks.back());
+    unordered_map<Operand, int, OperandHash>::iterator it = keptUntil.find(v);
+    if (it == keptUntil.end())
+        it = keptUntil.insert(make_pair(v, max(def, LastRead(v)))).first;
+    if (b <= it->second)
+        return true;
+    if (pressure.empty())
+        pressure = BlockPressure(analyses.GetLiveness());
+    if (!TakeRegisterAcross(pressure, it->second + 1, b))
+        return false;
+    it->second = b;
+    return true;
+}
+
+// Whether instruction i only has its result copied. The backend then
+// computes it straight into the copy, which reading another value that
+// holds it instead would still need.
+bool RedundancyElimination::OnlyCopied(int i) {
+    const Operand &v = code[i].dst;
+    return chains.NumUses(v) == 1 && code[chains.UseAt(v, 0).instr].type == TAC_Assign;
+}
+
+// The value holding the result of e in block b, from a block dominating
+// it or earlier in b itself, or none
+Operand RedundancyElimination::Available(const Expression &e, int b) {
+    unordered_map<Expression, vector<pair<int, Operand> >, ExpressionHash>::iterator it = computed.find(e);
+    if (it == computed.end())
+        return Operand();
+    const vector<pair<int, Operand> > &where = it->second;
+    for (int k = where.size() - 1; k >= 0; k--) {
+        if (dom.Dominates(where[k].first, b))
+            return where[k].second;
+    }
+    return Operand();
+}
+
+// The value number o has at the end of predecessor k of block b: the
+// argument for that edge if o is a phi of b, o itself if it is written
+// above b. Fails if o is written in b by anything else.
+bool RedundancyElimination::Translate(const Operand &o, int b, int k, const PhiArgsByDst &phiArgs,
+                                      Operand &result) {
+    PhiArgsByDst::const_iterator it = phiArgs.find(o);
+    if (it != phiArgs.end()) {
+        const Operand &arg = it->second[k];
+        if (!IsStable(arg))
+            return false;
+        result = NumberOf(arg);
+        return true;
+    }
+    if (BlockOf(o) == b)
+        return false;
+    result = o;
+    return true;
+}
+
+// Replaces instruction i, computing e in block b, by a phi of the values
+// holding e at the end of the predecessors of b, if all of them have one
+// or all but one, which then gets a copy of the operation
+bool RedundancyElimination::Merge(int i, const Expression &e, int b, PhiArgsByDst &phiArgs) {
+    const vector<int> &preds = cfg.blocks[b].preds;
+    if (!fn->inSSA || preds.size() < 2)
+        return false;
+    if (OnlyCopied(i))
+        return false;
+    for (int k = 0; k < preds.size(); k++) {
+        if (!dom.IsReachable(preds[k]) || find(preds.begin(), preds.begin() + k, preds[k]) != preds.begin() + k)
+            return false;
+    }
+
+    vector<Operand> args(preds.size());
+    int missing = -1;
+    Expression missed;
+    for (int k = 0; k < preds.size(); k++) {
+        Operand left, right;
+        if (!Translate(e.left, b, k, phiArgs, left) || !Translate(e.right, b, k, phiArgs, right))
+            return false;
+        Expression along(e.op, left, right);
+        args[k] = Available(along, preds[k]);
+        if (!args[k].IsNone())
+            continue;
+        if (missing >= 0)
+            return false;
+        missing = k;
+        missed = along;
+    }
+
+    if (missing >= 0) {
+        int p = preds[missing];
+        if (e.op == OP_Div || cfg.blocks[p].succs.size() != 1 || dom.Dominates(b, p) ||
+            !IsAvailableAt(missed.left, p) || !IsAvailableAt(missed.right, p) ||
+            !KeepUntil(missed.left, p) || !KeepUntil(missed.right, p))
+            return false;
+    }
+    // the phi reads each value at the end of its predecessor
+    for (int k = 0; k < preds.size(); k++) {
+        if (k != missing && !KeepUntil(args[k], preds[k]))
+            return false;
+    }
+
+    Operand var;
+    if (missing >= 0) {
+        int p = preds[missing];
+        var = fn->NewVariable("pre");
+        TACObject copy = NewOperation(missed.op, NewVersion(fn, var), missed.left, missed.right);
+        copies.push_back(make_pair(EndOf(code, cfg.blocks[p]), vector<TACObject>(1, copy)));
+        newValues[copy.dst] = p;
+        computed[missed].push_back(make_pair(p, copy.dst));
+        args[missing] = copy.dst;
+        partiallyRedundant++;
+        copiesPlaced++;
+    }
+    else {
+        var = fn->NewVariable("pre");
+        fullyRedundant++;
+    }
+
+    TACObject phi = NewPhi(NewVersion(fn, var), preds.size(), Operand());
+    PhiArgs(phi) = args;
+    phis.push_back(make_pair(TopOf(code, cfg.blocks[b]), phi));
+    phisPlaced++;
+    newValues[phi.dst] = b;
+    phiArgs[phi.dst] = args;
+    computed[e].push_back(make_pair(b, phi.dst));
+    chains.ReplaceAllUsesWith(code[i].dst, phi.dst);
+    chains.Erase(i);
+    return true;
+}
+
+void RedundancyElimination::Visit(int b) {
+    const BasicBlock &block = cfg.blocks[b];
+    PhiArgsByDst phiArgs;
+    for (int i = block.begin; i < block.end; i++) {
+        const TACObject &t = code[i];
+        if (t.type == TAC_Phi) {
+            phiArgs[t.dst] = PhiArgs(t);
+            continue;
+        }
+        if (t.deadMarked || !IsStable(t.dst))
+            continue;
+        if (t.type == TAC_Assign) {
+            if (IsStable(t.src1))
+                numberOf[t.dst] = NumberOf(t.src1);
+            continue;
+        }
+        if (t.type != TAC_BinaryOp || !IsStable(t.src1) || !IsStable(t.src2))
+            continue;
+
+        Expression e(t.ops, NumberOf(t.src1), NumberOf(t.src2));
+        Operand leader = Available(e, b);
+        if (!leader.IsNone() && !(BlockOf(leader) == b && OnlyCopied(i))) {
+            chains.ReplaceAllUsesWith(t.dst, leader);
+            chains.Erase(i);
+            fullyRedundant++;
+            continue;
+        }
+        if (!Merge(i, e, b, phiArgs))
+            computed[e].push_back(make_pair(b, t.dst));
+    }
+}
+
+// Walks the dominator tree, so the blocks dominating a block are done
+// before it
+void RedundancyElimination::Run() {
+    vector<int> stack(1, 0);
+    while (!stack.empty()) {
+        int b = stack.back();
+        stack.pop_back();
+        Visit(b);
+        for (int k = dom.children[b].size() - 1; k >= 0; k--)
+            stack.push_back(dom.children[b][k]);
+    }
+}
+
+void RedundancyElimination::Apply() {
+    // a temporary joined by a phi is renamed to a version of the phi's
+    // variable, unless it already is one of another
+    unordered_map<Operand, Operand, OperandHash> renamed;
+    for (int k = 0; k < phis.size(); k++) {
+        TACObject &phi = phis[k].second;
+        Operand var = fn->ssaVersions[phi.dst.slot];
+        vector<Operand> &args = PhiArgs(phi);
+        for (int a = 0; a < args.size(); a++) {
+            unordered_map<Operand, Operand, OperandHash>::iterator it = renamed.find(args[a]);
+            if (it != renamed.end()) {
+                args[a] = it->second;
+                continue;
+            }
+            if (!args[a].IsTemp() || chains.NumDefs(args[a]) != 1)
+                continue;
+            Operand version = NewVersion(fn, var);
+            int def = chains.DefAt(args[a], 0);
+            TACObject t = code[def];
+            t.dst = version;
+            chains.Replace(def, t);
+            chains.ReplaceAllUsesWith(args[a], version);
+            renamed[args[a]] = version;
+            args[a] = version;
+        }
+    }
+    for (int k = 0; k < copies.size(); k++) {
+        TACObject &copy = copies[k].second[0];
+        if (renamed.count(copy.src1) > 0)
+            copy.src1 = renamed[copy.src1];
+        if (renamed.count(copy.src2) > 0)
+            copy.src2 = renamed[copy.src2];
+    }
+
+    for (int k = 0; k < phis.size(); k++)
+        copies.push_back(make_pair(phis[k].first, vector<TACObject>(1, phis[k].second)));
+    InsertAll(code, copies);
+    RemoveDeadMarked(code);
+}
+
+bool GlobalValueNumbering(TACFunction *fn, AnalysisManager &analyses) {
+    if (fn->code.empty())
+        return false;
+    RedundancyElimination gvn(fn, analyses);
+    gvn.Run();
+    gvn.Apply();
+    PrintDebug("gvn", "%s: %d operations fully redundant, %d partially, %d copies and %d "
+               "phis placed", fn->IsTopLevel() ? "(top level)" : NameOf(fn->name.value).c_str(),
+               gvn.fullyRedundant, gvn.partiallyRedundant, gvn.copiesPlaced, gvn.phisPlaced);
+    return gvn.fullyRedundant > 0 || gvn.partiallyRedundant > 0;
+}
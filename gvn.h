@@ -0,0 +1,47 @@
+/* File: gvn.h
+ * -----------
+ * Global value numbering with partial redundancy elimination over one
+ * function's TAC.
+ *
+ * Only values that keep what they were given wherever they are read
+ * take part: constants, and values written once by an instruction that
+ * dominates every read of them, which in SSA form is nearly all of them.
+ * A copy of such a value gets its number, and an operation on numbers is
+ * known by its operator and operands, put in one order as local value
+ * numbering does. The blocks are walked down the dominator tree, so an
+ * operation computed in a block that dominates another is available
+ * there, and recomputing it there is fully redundant.
+ *
+ * In SSA form an operation that is not available yet in its block may
+ * be available at the end of each predecessor, with the operands that
+ * are phis of the block taken along the edge from there. A phi then
+ * joins the results and the operation goes. If all predecessors but one
+ * have the result, the operation is partially redundant; a copy of it is
+ * put at the end of the one without, when that block leads only to this
+ * one and is not a back edge, so no path computes it more often than
+ * before. A division is never moved, as it could trap. Each value the
+ * phi and the copy read is then kept in a register on to the end of a
+ * predecessor, which is only done while TakeRegisterAcross finds one to
+ * spare there: a phi whose arguments are spilled costs more than the
+ * operation it saves. The values joined
+ * are made versions of a new variable, so that leaving SSA form merges
+ * them back into one and the phi costs no copies.
+ */
+
+#ifndef _H_gvn
+#define _H_gvn
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: GlobalValueNumbering
+ * ------------------------------
+ * Removes fully and partially redundant operations, through the def-use
+ * chains, in place, and returns whether anything changed. The "gvn"
+ * debug key prints, for each function, how many operations were found
+ * fully redundant and partially redundant, and the copies and phis
+ * placed to remove them.
+ */
+bool GlobalValueNumbering(TACFunction *fn, AnalysisManager &analyses);
+
+#endif
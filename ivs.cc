@@ -0,0 +1,384 @@
+/* File: ivs.cc
+ * ------------
+ * Implementation of induction-variable strength reduction and
+ * linear-function test replacement.
+ */
+
+#include "ivs.h"
+#include "ssa.h"
+#include "utility.h"
+#include <algorithm>
+#include <limits.h>
+#include <unordered_set>
+
+// Folds a * b where that takes no multiply: both are constants, or one
+// is 0 or 1
+static bool FoldProduct(const Operand &a, const Operand &b, Operand &result) {
+    if (a.IsConstant() && b.IsConstant())
+        return FoldOperation(OP_Mul, a, b, result);
+    for (int k = 0; k < 2; k++) {
+        const Operand &c = k == 0 ? a : b, &other = k == 0 ? b : a;
+        if (c.kind == OPND_Int && (c.value == 0 || c.value == 1)) {
+            result = c.value == 0 ? c : other;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool FitsInt(long long v) {
+    return v >= INT_MIN && v <= INT_MAX;
+}
+
+struct BasicIV {
+    int phi;
+    Operand value, init, step;
+    int op;                     // OP_Add or OP_Sub, of value and step
+    int update;                 // the instruction applying the step
+    vector<int> cycle;          // the phi, the update and the copies
+                                // carrying its result back to the phi
+    vector<pair<Operand, Operand> > products;   // (factor, variable)
+};
+
+class InductionVariables {
+  public:
+    int reduced, replaced, removed;
+
+    InductionVariables(TACFunction *fn, AnalysisManager &analyses);
+    // Does loop l, which must not be done before the loops inside it
+    void Simplify(int l);
+    // Puts the new phis, updates and products into the code
+    void Apply();
+
+  private:
+    TACFunction *fn;
+    vector<TACObject> &code;
+    const CFG &cfg;
+    const Dominators &dom;
+    const LoopInfo &loops;
+    DefUse &chains;
+    vector<int> pressure;       // by loop
+    Insertions inserts;
+    // the values the instructions still to be inserted read, which the
+    // chains don't know of
+    unordered_set<Operand, OperandHash> pendingReads;
+
+    void Insert(int at, const TACObject &t);
+    bool FindBasic(int phi, int l, BasicIV &iv);
+    bool ReadOnlyInCycle(const BasicIV &iv, bool phiToo);
+    void RemoveCycle(const BasicIV &iv);
+    bool Reduce(int i, BasicIV &iv, const Operand &factor, int l);
+    bool Range(const BasicIV &iv, int l, long long &low, long long &high);
+    bool ReplaceTests(BasicIV &iv, int l);
+};
+
+InductionVariables::InductionVariables(TACFunction *fn, AnalysisManager &analyses)
+    : reduced(0), replaced(0), removed(0), fn(fn), code(fn->code), cfg(analyses.GetCFG()),
+      dom(analyses.GetDominators()), loops(analyses.GetLoops()), chains(analyses.GetDefUse()),
+      pressure(LoopPressure(loops, analyses.GetLiveness())) {}
+
+void InductionVariables::Insert(int at, const TACObject &t) {
+    inserts.push_back(make_pair(at, vector<TACObject>(1, t)));
+    vector<Operand> reads = t.type == TAC_Phi ? PhiArgs(t) : vector<Operand>();
+    reads.push_back(t.src1);
+    reads.push_back(t.src2);
+    for (int k = 0; k < reads.size(); k++) {
+        if (reads[k].IsValue())
+            pendingReads.insert(reads[k]);
+    }
+}
+
+// Whether the phi at instruction phi of the header of loop l is a basic
+// induction variable, filling in iv if so
+bool InductionVariables::FindBasic(int phi, int l, BasicIV &iv) {
+    const TACObject &t = code[phi];
+    const vector<Operand> &args = PhiArgs(t);
+    const vector<int> &preds = cfg.blocks[loops.loops[l].header].preds;
+    Operand next;
+    for (int k = 0; k < preds.size(); k++) {
+        if (!loops.Contains(l, preds[k]))
+            iv.init = args[k];
+        else if (next.IsNone())
+            next = args[k];
+        else if (args[k] != next)
+            return false;
+    }
+
+    // back through the copies to the update
+    iv.phi = phi;
+    iv.value = t.dst;
+    iv.cycle.assign(1, phi);
+    for (Operand v = next; ; ) {
+        if (!v.IsValue() || v.IsGlobal() || chains.NumDefs(v) != 1 || iv.cycle.size() > 4)
+            return false;
+        int d = chains.DefAt(v, 0);
+        const TACObject &u = code[d];
+        if (!loops.Contains(l, cfg.blockOf[d]) || u.deadMarked)
+            return false;
+        iv.cycle.push_back(d);
+        if (u.type == TAC_Assign) {
+            v = u.src1;
+            continue;
+        }
+        if (u.type != TAC_BinaryOp || (u.ops != OP_Add && u.ops != OP_Sub))
+            return false;
+        if (u.src1 == iv.value && IsInvariant(loops, cfg.blockOf, chains, l, u.src2))
+            iv.step = u.src2;
+        else if (u.ops == OP_Add && u.src2 == iv.value && IsInvariant(loops, cfg.blockOf, chains, l, u.src1))
+            iv.step = u.src1;
+        else
+            return false;
+        iv.op = u.ops;
+        iv.update = d;
+        return true;
+    }
+}
+
+// Whether the values of iv's cycle are read by nothing outside it, the
+// phi's own value aside unless phiToo
+bool InductionVariables::ReadOnlyInCycle(const BasicIV &iv, bool phiToo) {
+    for (int c = 0; c < iv.cycle.size(); c++) {
+        const Operand &v = code[iv.cycle[c]].dst;
+        if (!phiToo && v == iv.value)
+            continue;
+        if (pendingReads.count(v) > 0)
+            return false;
+        for (int k = 0; k < chains.NumUses(v); k++) {
+            int at = chains.UseAt(v, k).instr;
+            if (find(iv.cycle.begin(), iv.cycle.end(), at) == iv.cycle.end())
+                return false;
+        }
+    }
+    return true;
+}
+
+void InductionVariables::RemoveCycle(const BasicIV &iv) {
+    for (int c = 0; c < iv.cycle.size(); c++)
+        chains.Erase(iv.cycle[c]);
+    removed++;
+}
+
+// Replaces the multiply at instruction i, of iv by factor, with a read
+// of a variable kept equal to the product, returning whether it could
+bool InductionVariables::Reduce(int i, BasicIV &iv, const Operand &factor, int l) {
+    const Loop &loop = loops.loops[l];
+    Operand product;
+    for (int k = 0; k < iv.products.size() && product.IsNone(); k++) {
+        if (iv.products[k].first == factor)
+            product = iv.products[k].second;
+    }
+
+    if (product.IsNone()) {
+        // the new variable lives all through the loop, and so does its
+        // step unless that is a constant or the factor, which the
+        // multiply read there anyway
+        Operand step;
+        bool stepFolds = FoldProduct(iv.step, factor, step);
+        if (!TakeRegister(loops, pressure, l) || (!stepFolds && !TakeRegister(loops, pressure, l)))
+            return false;
+        int preheader = loops.Preheader(cfg, l);
+        int end = EndOf(code, cfg.blocks[preheader]);
+        Operand var = fn->NewVariable("iv");
+        Operand start;
+        if (!FoldProduct(iv.init, factor, start)) {
+            start = NewVersion(fn, var);
+            Insert(end, NewOperation(OP_Mul, start, iv.init, factor));
+        }
+        if (!stepFolds) {
+            step = fn->NewVariable("step");
+            Insert(end, NewOperation(OP_Mul, step, iv.step, factor));
+        }
+
+        product = NewVersion(fn, var);
+        Operand next = NewVersion(fn, var);
+        const vector<int> &preds = cfg.blocks[loop.header].preds;
+        TACObject phi = NewPhi(product, preds.size(), next);
+        PhiArgs(phi)[cfg.PredIndex(loop.header, preheader)] = start;
+        Insert(TopOf(code, cfg.blocks[loop.header]), phi);
+        // at the very end of the trip, so the product is never live
+        // together with the next one and they can share a register
+        int at = loop.latches.size() == 1 ? EndOf(code, cfg.blocks[loop.latches[0]]) : iv.update + 1;
+        int op = iv.op;
+        if (op == OP_Sub && step.kind == OPND_Int) {
+            FoldOperation(OP_Sub, Operand::Int(0), step, step);
+            op = OP_Add;
+        }
+        Insert(at, NewOperation(op, next, product, step));
+        iv.products.push_back(make_pair(factor, product));
+    }
+
+    chains.ReplaceAllUsesWith(code[i].dst, product);
+    chains.Erase(i);
+    reduced++;
+    return true;
+}
+
+// The lowest and highest values iv takes while loop l runs, if the test
+// leaving the header fixes them: every trip starts there, so the values
+// are those from the initial one up to the first that fails the test
+bool InductionVariables::Range(const BasicIV &iv, int l, long long &low, long long &high) {
+    int h = loops.loops[l].header;
+    const BasicBlock &header = cfg.blocks[h];
+    const TACObject &jump = code[header.end - 1];
+    if (!iv.init.IsConstant() || !iv.step.IsConstant() || jump.type != TAC_IfGoto ||
+        !jump.src1.IsValue() || jump.src1.IsGlobal() || chains.NumDefs(jump.src1) != 1)
+        return false;
+    int d = chains.DefAt(jump.src1, 0);
+    const TACObject &test = code[d];
+    if (cfg.blockOf[d] != h || test.type != TAC_BinaryOp || !IsComparison(test.ops))
+        return false;
+    int op;
+    long long bound;
+    if (test.src1 == iv.value && test.src2.IsConstant()) {
+        op = test.ops;
+        bound = test.src2.value;
+    }
+    else if (test.src2 == iv.value && test.src1.IsConstant()) {
+        op = MirroredComparison(test.ops);
+        bound = test.src1.value;
+    }
+    else {
+        return false;
+    }
+    // the loop goes on while op holds
+    int taken = cfg.BlockForLabel(jump.src2);
+    if (header.succs.size() != 2 || taken < 0)
+        return false;
+    bool stays = loops.Contains(l, taken);
+    int other = header.succs[0] == taken ? header.succs[1] : header.succs[0];
+    if (loops.Contains(l, other) == stays)
+        return false;
+    if (!stays)
+        op = NegatedComparison(op);
+
+    long long first = iv.init.value;
+    long long step = iv.op == OP_Add ? (long long)iv.step.value : -(long long)iv.step.value;
+    long long trips = CountTrips(op, first, step, bound);
+    if (trips < 0)
+        return false;
+    low = min(first, first + trips * step);
+    high = max(first, first + trips * step);
+    return true;
+}
+
+// Compares iv through one of its products by a constant instead, where
+// it is compared with a constant, if that is all it is read by, and
+// returns whether it did
+bool InductionVariables::ReplaceTests(BasicIV &iv, int l) {
+    Operand factor, product;
+    for (int k = 0; k < iv.products.size() && product.IsNone(); k++) {
+        if (iv.products[k].first.IsConstant() && iv.products[k].first.value != 0) {
+            factor = iv.products[k].first;
+            product = iv.products[k].second;
+        }
+    }
+    long long low, high;
+    if (product.IsNone() || pendingReads.count(iv.value) > 0 || !Range(iv, l, low, high) ||
+        !FitsInt(low * factor.value) || !FitsInt(high * factor.value))
+        return false;
+
+    vector<int> tests;
+    for (int k = 0; k < chains.NumUses(iv.value); k++) {
+        const Use &use = chains.UseAt(iv.value, k);
+        if (find(iv.cycle.begin(), iv.cycle.end(), use.instr) != iv.cycle.end())
+            continue;
+        const TACObject &t = code[use.instr];
+        const Operand &other = use.operand == 0 ? t.src2 : t.src1;
+        if (use.operand > 1 || t.type != TAC_BinaryOp || !IsComparison(t.ops) || other.kind != OPND_Int ||
+            !FitsInt((long long)other.value * factor.value))
+            return false;
+        tests.push_back(use.instr);
+    }
+    for (int k = 0; k < tests.size(); k++) {
+        TACObject t = code[tests[k]];
+        if (t.src1 == iv.value) {
+            t.src1 = product;
+            t.src2 = Operand::Int(t.src2.value * factor.value);
+        }
+        else {
+            t.src2 = product;
+            t.src1 = Operand::Int(t.src1.value * factor.value);
+        }
+        // a negative factor turns the order around
+        if (factor.value < 0)
+            t.ops = MirroredComparison(t.ops);
+        chains.Replace(tests[k], t);
+        replaced++;
+    }
+    return true;
+}
+
+void InductionVariables::Simplify(int l) {
+    const Loop &loop = loops.loops[l];
+    if (loops.Preheader(cfg, l) < 0)
+        return;
+    const BasicBlock &header = cfg.blocks[loop.header];
+    vector<BasicIV> ivs;
+    for (int i = header.begin; i < header.end; i++) {
+        BasicIV iv;
+        if (code[i].type == TAC_Phi && FindBasic(i, l, iv))
+            ivs.push_back(iv);
+    }
+    if (ivs.empty())
+        return;
+
+    // a variable with the start and step of an earlier one is that one,
+    // if nothing else reads its update
+    for (int k = 1; k < ivs.size(); k++) {
+        for (int e = 0; e < k; e++) {
+            if (ivs[e].init == ivs[k].init && ivs[e].step == ivs[k].step && ivs[e].op == ivs[k].op &&
+                ReadOnlyInCycle(ivs[k], false) && pendingReads.count(ivs[k].value) == 0) {
+                RemoveCycle(ivs[k]);
+                chains.ReplaceAllUsesWith(ivs[k].value, ivs[e].value);
+                ivs.erase(ivs.begin() + k--);
+                break;
+            }
+        }
+    }
+
+    // the multiplies on every trip, outside the loops inside this one
+    for (int k = 0; k < loop.blocks.size(); k++) {
+        int b = loop.blocks[k];
+        bool onAll = loops.LoopOf(b) == l;
+        for (int n = 0; n < loop.latches.size() && onAll; n++)
+            onAll = dom.Dominates(b, loop.latches[n]);
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end && onAll; i++) {
+            const TACObject &t = code[i];
+            if (t.deadMarked || t.type != TAC_BinaryOp || t.ops != OP_Mul || !t.dst.IsValue() ||
+                t.dst.IsGlobal() || chains.NumDefs(t.dst) != 1)
+                continue;
+            for (int v = 0; v < ivs.size(); v++) {
+                const Operand &factor = t.src1 == ivs[v].value ? t.src2 : t.src1;
+                if ((t.src1 == ivs[v].value || t.src2 == ivs[v].value) &&
+                    IsInvariant(loops, cfg.blockOf, chains, l, factor)) {
+                    Reduce(i, ivs[v], factor, l);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int v = 0; v < ivs.size(); v++) {
+        if (!ReadOnlyInCycle(ivs[v], true))
+            ReplaceTests(ivs[v], l);
+        if (ReadOnlyInCycle(ivs[v], true))
+            RemoveCycle(ivs[v]);
+    }
+}
+
+void InductionVariables::Apply() {
+    InsertAll(code, inserts);
+    RemoveDeadMarked(code);
+}
+
+bool ReduceInductionVariables(TACFunction *fn, AnalysisManager &analyses) {
+    if (fn->code.empty() || !fn->inSSA || analyses.GetLoops().loops.empty())
+        return false;
+    InductionVariables ivs(fn, analyses);
+    for (int l = 0; l < analyses.GetLoops().loops.size(); l++)
+        ivs.Simplify(l);
+    ivs.Apply();
+    PrintDebug("ivs", "%s: %d multiplies reduced, %d tests replaced, %d variables removed",
+               NameOf(fn->name.value).c_str(), ivs.reduced, ivs.replaced, ivs.removed);
+    return ivs.reduced > 0 || ivs.replaced > 0 || ivs.removed > 0;
+}
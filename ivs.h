@@ -0,0 +1,56 @@
+/* File: ivs.h
+ * -----------
+ * Induction-variable strength reduction and linear-function test
+ * replacement over one function's TAC in SSA form.
+ *
+ * A basic induction variable is a phi of a loop header that takes one
+ * value on the way in and, around every back edge, itself plus or minus
+ * a step that is the same all through the loop, maybe through a few
+ * copies, such as i.2 in
+ *
+ *     i.2 := phi(0, i.3)
+ *     ...
+ *     t5 := i.2 + 1
+ *     i.3 := t5
+ *
+ * A product of one with a value that doesn't change in the loop, in a
+ * block run on every trip around it, is then a variable of its own: it
+ * starts at the product of the initial value in the preheader and goes
+ * up by the product of the step at the end of each trip, so the multiply
+ * leaves the loop, if the loop has a register to spare for the variable.
+ * Products by the same factor share one variable. Both sides wrap around
+ * on overflow the same way, so the new variable always holds the product
+ * exactly.
+ *
+ * Once the multiplies have gone, a basic variable read by nothing but
+ * comparisons with constants can be compared through one of its
+ * products by a constant instead, the constant scaled to match, and then
+ * it has no reads left. This is only done when the initial value, the
+ * step and the header's exit test fix every value the variable takes,
+ * and none of the products overflows, as comparing wrapped products
+ * would not give the same answers.
+ *
+ * Basic variables of one loop with the same start and step are one, and
+ * a basic variable read by nothing but its own update is gone, together
+ * with the update; eliminating dead code can't tell, as the phi and the
+ * update keep each other live.
+ */
+
+#ifndef _H_ivs
+#define _H_ivs
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: ReduceInductionVariables
+ * ----------------------------------
+ * Strength-reduces the multiplies of induction variables, replaces the
+ * tests of the variables that are then only compared and removes the
+ * redundant ones, in place, returning whether anything changed. Does
+ * nothing to a function not in SSA form. The "ivs" debug key prints, for
+ * each function, the multiplies reduced, the tests replaced and the
+ * variables removed.
+ */
+bool ReduceInductionVariables(TACFunction *fn, AnalysisManager &analyses);
+
+#endif
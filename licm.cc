@@ -0,0 +1,284 @@
+/* File: licm.cc
+ * -------------
+ * Implementation of loop-invariant code motion.
+ */
+
+#include "licm.h"
+#include "utility.h"
+#include <algorithm>
+
+// A new preheader takes the place of the entry among the predecessors of
+// header h, which are in code order, so its argument moves with it in
+// every phi of h; the preheader comes right before h
+static void MovePhiArgs(vector<TACObject> &code, const CFG &cfg, int h, int entry) {
+    const vector<int> &preds = cfg.blocks[h].preds;
+    vector<pair<int, int> > order;
+    for (int k = 0; k < preds.size(); k++)
+        order.push_back(make_pair(preds[k] == entry ? 2 * h - 1 : 2 * preds[k], k));
+    sort(order.begin(), order.end());
+    for (int i = cfg.blocks[h].begin; i < cfg.blocks[h].end; i++) {
+        if (code[i].type != TAC_Phi)
+            continue;
+        vector<Operand> &args = PhiArgs(code[i]);
+        vector<Operand> moved(args.size());
+        for (int k = 0; k < order.size(); k++)
+            moved[k] = args[order[k].second];
+        args.swap(moved);
+    }
+}
+
+// Gives the loops that lack a preheader a new one above the header,
+// returning how many it made
+static int MakePreheaders(TACFunction *fn, AnalysisManager &analyses) {
+    vector<TACObject> &code = fn->code;
+    const CFG &cfg = analyses.GetCFG();
+    const LoopInfo &loops = analyses.GetLoops();
+    Insertions inserts;
+    for (int l = 0; l < loops.loops.size(); l++) {
+        int h = loops.loops[l].header;
+        const BasicBlock &header = cfg.blocks[h];
+        vector<int> entries = loops.Entries(cfg, l);
+        // the code generator never lays a loop out falling into its own
+        // header from the block above
+        const vector<int> &preds = header.preds;
+        bool fallsIn = h > 0 && loops.Contains(l, h - 1) && code[cfg.blocks[h - 1].end - 1].type != TAC_Goto &&
+                       find(preds.begin(), preds.end(), h - 1) != preds.end();
+        if (entries.empty() || loops.Preheader(cfg, l) >= 0 || code[header.begin].type != TAC_Label ||
+            fallsIn || (fn->inSSA && entries.size() > 1))
+            continue;
+
+        const Operand label = code[header.begin].src1;
+        Operand preheader = NewLabel();
+        inserts.push_back(make_pair(header.begin, vector<TACObject>(1, NewJump(TAC_Label, preheader))));
+        for (int k = 0; k < entries.size(); k++) {
+            TACObject &last = code[cfg.blocks[entries[k]].end - 1];
+            if (last.type == TAC_Goto && last.src1 == label)
+                last.src1 = preheader;
+            else if (last.type == TAC_IfGoto && last.src2 == label)
+                last.src2 = preheader;
+        }
+        if (fn->inSSA)
+            MovePhiArgs(code, cfg, h, entries[0]);
+    }
+    InsertAll(code, inserts);
+    return inserts.size();
+}
+
+// Keeps the globals loop l uses in locals while it runs, adding the
+// loads to go into its preheader and the stores to go into its exits;
+// returns how many globals it kept, and counts those written in sunk
+static int PromoteGlobals(TACFunction *fn, const CFG &cfg, const LoopInfo &loops, int l,
+                          vector<int> &pressure, Insertions &loads, Insertions &stores, int &sunk) {
+    vector<TACObject> &code = fn->code;
+    const vector<int> &blocks = loops.loops[l].blocks;
+    int preheader = loops.Preheader(cfg, l);
+    if (preheader < 0)
+        return 0;
+    vector<int> exits;
+    for (int k = 0; k < blocks.size(); k++) {
+        const BasicBlock &b = cfg.blocks[blocks[k]];
+        for (int i = b.begin; i < b.end; i++) {
+            if (code[i].type == TAC_Call || code[i].type == TAC_Return)
+                return 0;
+        }
+        for (int s = 0; s < b.succs.size(); s++) {
+            if (!loops.Contains(l, b.succs[s]) && find(exits.begin(), exits.end(), b.succs[s]) == exits.end())
+                exits.push_back(b.succs[s]);
+        }
+    }
+    for (int e = 0; e < exits.size(); e++) {
+        const vector<int> &preds = cfg.blocks[exits[e]].preds;
+        for (int k = 0; k < preds.size(); k++) {
+            if (!loops.Contains(l, preds[k]))
+                return 0;
+        }
+    }
+
+    // the local each global is kept in, in the order they were met
+    vector<Operand> globals, locals;
+    vector<bool> written;
+    unordered_map<int, int> indexOf;    // by global slot, -1 if left be
+    for (int k = 0; k < blocks.size(); k++) {
+        const BasicBlock &b = cfg.blocks[blocks[k]];
+        for (int i = b.begin; i < b.end; i++) {
+            TACObject &t = code[i];
+            Operand *opnds[] = { &t.dst, &t.src1, &t.src2 };
+            for (int n = 0; n < 3; n++) {
+                Operand &o = *opnds[n];
+                if (!o.IsGlobal() || (n == 0 && !DefinesValue(t)))
+                    continue;
+                unordered_map<int, int>::iterator it = indexOf.find(o.slot);
+                if (it == indexOf.end() && !TakeRegister(loops, pressure, l)) {
+                    indexOf[o.slot] = -1;
+                    continue;
+                }
+                if (it == indexOf.end()) {
+                    int slot = fn->NewSlot();
+                    it = indexOf.insert(make_pair((int)o.slot, (int)globals.size())).first;
+                    globals.push_back(o);
+                    locals.push_back(Operand::Var(InternName("promoted." + to_string(slot)), slot));
+                    written.push_back(false);
+                }
+                if (it->second < 0)
+                    continue;
+                if (n == 0)
+                    written[it->second] = true;
+                o = locals[it->second];
+            }
+        }
+    }
+
+    for (int g = 0; g < globals.size(); g++) {
+        loads.push_back(make_pair(EndOf(code, cfg.blocks[preheader]),
+                                  vector<TACObject>(1, NewCopy(locals[g], globals[g]))));
+        if (!written[g])
+            continue;
+        sunk++;
+        for (int e = 0; e < exits.size(); e++) {
+            stores.push_back(make_pair(TopOf(code, cfg.blocks[exits[e]]),
+                                       vector<TACObject>(1, NewCopy(globals[g], locals[g]))));
+        }
+    }
+    return globals.size();
+}
+
+class CodeMotion {
+  public:
+    int hoisted;
+
+    CodeMotion(vector<TACObject> &code, AnalysisManager &analyses);
+    // Moves what is invariant in loop l, once the loops inside it are done
+    void HoistOutOf(int l);
+    // Moves the instructions to where HoistOutOf() put them last
+    void Apply();
+
+  private:
+    vector<TACObject> &code;
+    const CFG &cfg;
+    const Dominators &dom;
+    const LoopInfo &loops;
+    DefUse &chains;
+    vector<int> blockOf;        // of each instruction, after its moves
+    vector<int> movedAt;        // when it last moved, -1 if never
+    vector<int> everyTripOf;    // by block, the last loop found to run
+                                // it on every trip around
+    int moves;
+    vector<int> pressure;       // by loop
+    vector<signed char> dominatesUses;  // by slot, -1 until known
+
+    bool CanHoist(int i, int l);
+};
+
+CodeMotion::CodeMotion(vector<TACObject> &code, AnalysisManager &analyses)
+    : hoisted(0), code(code), cfg(analyses.GetCFG()), dom(analyses.GetDominators()),
+      loops(analyses.GetLoops()), chains(analyses.GetDefUse()), blockOf(cfg.blockOf),
+      movedAt(code.size(), -1), everyTripOf(cfg.NumBlocks(), -1), moves(0),
+      pressure(LoopPressure(loops, analyses.GetLiveness())) {}
+
+bool CodeMotion::CanHoist(int i, int l) {
+    const TACObject &t = code[i];
+    if (t.deadMarked || (t.type != TAC_BinaryOp && t.type != TAC_Assign))
+        return false;
+    if (!t.dst.IsValue() || t.dst.IsGlobal() || chains.NumDefs(t.dst) != 1)
+        return false;
+    if (t.type == TAC_BinaryOp && t.ops == OP_Div && (!t.src2.IsConstant() || t.src2.value == 0))
+        return false;
+    if (!IsInvariant(loops, blockOf, chains, l, t.src1) ||
+        (t.type == TAC_BinaryOp && !IsInvariant(loops, blockOf, chains, l, t.src2)))
+        return false;
+    if (t.dst.slot >= dominatesUses.size())
+        dominatesUses.resize(t.dst.slot + 1, -1);
+    if (dominatesUses[t.dst.slot] < 0)
+        dominatesUses[t.dst.slot] = DominatesUses(chains, cfg, dom, t.dst);
+    return dominatesUses[t.dst.slot];
+}
+
+void CodeMotion::HoistOutOf(int l) {
+    int preheader = loops.Preheader(cfg, l);
+    if (preheader < 0)
+        return;
+    // only code run on every trip around the loop moves, so that none
+    // runs more often than before once the loop is entered, and an
+    // instruction moves once those writing its operands have
+    const Loop &loop = loops.loops[l];
+    for (int k = 0; k < loop.blocks.size(); k++) {
+        int b = loop.blocks[k];
+        bool onAll = true;
+        for (int n = 0; n < loop.latches.size() && onAll; n++)
+            onAll = dom.Dominates(b, loop.latches[n]);
+        if (onAll)
+            everyTripOf[b] = l;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int k = 0; k < loop.blocks.size(); k++) {
+            const BasicBlock &b = cfg.blocks[loop.blocks[k]];
+            for (int i = b.begin; i < b.end; i++) {
+                if (everyTripOf[blockOf[i]] != l || !CanHoist(i, l))
+                    continue;
+                // once hoisted out of an inner loop, a value already
+                // has its register in this one
+                if (movedAt[i] < 0) {
+                    if (!TakeRegister(loops, pressure, l))
+                        continue;
+                    hoisted++;
+                }
+                blockOf[i] = preheader;
+                movedAt[i] = moves++;
+                changed = true;
+            }
+        }
+    }
+}
+
+void CodeMotion::Apply() {
+    vector<pair<int, int> > order;
+    for (int i = 0; i < code.size(); i++) {
+        if (movedAt[i] >= 0)
+            order.push_back(make_pair(movedAt[i], i));
+    }
+    sort(order.begin(), order.end());
+    Insertions inserts;
+    for (int k = 0; k < order.size(); k++) {
+        int i = order[k].second;
+        inserts.push_back(make_pair(EndOf(code, cfg.blocks[blockOf[i]]), vector<TACObject>(1, code[i])));
+        code[i].deadMarked = 1;
+    }
+    InsertAll(code, inserts);
+    RemoveDeadMarked(code);
+}
+
+bool LoopInvariantCodeMotion(TACFunction *fn, AnalysisManager &analyses) {
+    if (fn->code.empty() || analyses.GetLoops().loops.empty())
+        return false;
+    int preheaders = MakePreheaders(fn, analyses);
+    if (preheaders > 0)
+        analyses.Invalidate(ANALYSIS_None);
+
+    // outermost loops first, so a global is kept in a local through as
+    // much code as it can be
+    const CFG &cfg = analyses.GetCFG();
+    const LoopInfo &loops = analyses.GetLoops();
+    vector<int> pressure = LoopPressure(loops, analyses.GetLiveness());
+    Insertions loads, stores;
+    int promoted = 0, sunk = 0;
+    for (int l = loops.loops.size() - 1; l >= 0; l--)
+        promoted += PromoteGlobals(fn, cfg, loops, l, pressure, loads, stores, sunk);
+    if (promoted > 0) {
+        // a block may be both the exit of one loop and the preheader of
+        // the next, and the store leaving the one goes first
+        stores.insert(stores.end(), loads.begin(), loads.end());
+        InsertAll(fn->code, stores);
+        analyses.Invalidate(ANALYSIS_Dominators | ANALYSIS_Loops);
+    }
+
+    CodeMotion motion(fn->code, analyses);
+    for (int l = 0; l < analyses.GetLoops().loops.size(); l++)
+        motion.HoistOutOf(l);
+    motion.Apply();
+    PrintDebug("licm", "%s: %d preheaders added, %d globals kept in locals, %d stores sunk, "
+               "%d instructions hoisted", NameOf(fn->name.value).c_str(), preheaders, promoted,
+               sunk, motion.hoisted);
+    return preheaders > 0 || promoted > 0 || motion.hoisted > 0;
+}
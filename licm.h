@@ -0,0 +1,46 @@
+/* File: licm.h
+ * ------------
+ * Loop-invariant code motion over one function's TAC.
+ *
+ * Code hoisted out of a loop goes into its preheader, a block outside
+ * the loop that leads only into the header and that every way into the
+ * loop goes through. The code generator lays loops out with their test
+ * first, so the block falling into the test is usually one already; a
+ * loop without one gets a new block right above the header, and the
+ * jumps into the header from outside go to it instead. In SSA form this
+ * is only done when a single block leads into the loop, so that the
+ * header's phis don't have to be split.
+ *
+ * A loop with no calls, which may touch any global, and no returns,
+ * whose exits are entered from the loop alone, keeps each global it
+ * uses in a local of its own while it runs: the global is loaded into
+ * it in the preheader and, if the loop writes it, stored back at the
+ * top of each exit, so that the stores in the loop become copies.
+ *
+ * An operation or copy whose operands are written only outside the loop
+ * is then moved to the end of the preheader, if it is in a block run on
+ * every trip around the loop, and its destination is written there
+ * alone and that write comes before every read. Moving it still runs it
+ * once when the loop's body would not have run at all, so a division is
+ * only moved by a constant other than zero. Loops are taken innermost
+ * first, so code moved out of one loop can move on out of the loops
+ * around it.
+ */
+
+#ifndef _H_licm
+#define _H_licm
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: LoopInvariantCodeMotion
+ * ---------------------------------
+ * Adds the missing preheaders, keeps globals in locals through the loops
+ * that allow it and hoists the invariant code, in place, returning
+ * whether anything changed. The "licm" debug key prints, for each
+ * function, the preheaders added, the globals kept in locals and the
+ * stores that sank out of loops that way, and the instructions hoisted.
+ */
+bool LoopInvariantCodeMotion(TACFunction *fn, AnalysisManager &analyses);
+
+#endif
@@ -0,0 +1,144 @@
+/* File: liveness.cc
+ * -----------------
+ * Implementation of the liveness analysis.
+ */
+
+#include "liveness.h"
+#include <algorithm>
+
+int UsesOf(const TACObject &t, Operand uses[2]) {
+    // the source slots only ever hold values as operands being read;
+    // labels, names and counts there are not values
+    int n = 0;
+    if (t.src1.IsValue())
+        uses[n++] = t.src1;
+    if (t.src2.IsValue())
+        uses[n++] = t.src2;
+    return n;
+}
+
+bool DefinesValue(const TACObject &t) {
+    return (t.type == TAC_Assign || t.type == TAC_BinaryOp || t.type == TAC_Call ||
+            t.type == TAC_LoadParam || t.type == TAC_Phi) && t.dst.IsValue();
+}
+
+void PhiUsesOnExit(const vector<TACObject> &code, const CFG &cfg, int b, vector<Operand> &uses) {
+    const vector<int> &succs = cfg.blocks[b].succs;
+    for (int k = 0; k < succs.size(); k++) {
+        const BasicBlock &s = cfg.blocks[succs[k]];
+        int i = s.begin;
+        if (i < s.end && code[i].type == TAC_Label)
+            i++;
+        if (i == s.end || code[i].type != TAC_Phi)
+            continue;
+        int pred = cfg.PredIndex(succs[k], b);
+        for (; i < s.end && code[i].type == TAC_Phi; i++) {
+            const Operand &arg = PhiArgs(code[i])[pred];
+            if (arg.IsValue())
+                uses.push_back(arg);
+        }
+    }
+}
+
+int Liveness::IndexOf(const Operand &o) const {
+    unordered_map<Operand, int, OperandHash>::const_iterator it = indices.find(o);
+    return it == indices.end() ? -1 : it->second;
+}
+
+// Gives a value read in block b an index unless b itself wrote it first
+void Liveness::AddIfLiveIn(const Operand &o, int b, const unordered_map<Operand, int, OperandHash> &lastDef) {
+    if (o.IsGlobal())
+        return;
+    unordered_map<Operand, int, OperandHash>::const_iterator it = lastDef.find(o);
+    if ((it == lastDef.end() || it->second != b) &&
+        indices.insert(make_pair(o, (int)values.size())).second)
+        values.push_back(o);
+}
+
+Liveness::Liveness(const vector<TACObject> &code, const CFG &cfg) {
+    // a value read before it is written in some block is live on entry
+    // to that block; lastDef holds the block of each value's latest write
+    unordered_map<Operand, int, OperandHash> lastDef;
+    vector<Operand> exitUses;
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            Operand uses[2];
+            int numUses = UsesOf(code[i], uses);
+            for (int k = 0; k < numUses; k++)
+                AddIfLiveIn(uses[k], b, lastDef);
+            if (DefinesValue(code[i]))
+                lastDef[code[i].dst] = b;
+        }
+        exitUses.clear();
+        PhiUsesOnExit(code, cfg, b, exitUses);
+        for (int k = 0; k < exitUses.size(); k++)
+            AddIfLiveIn(exitUses[k], b, lastDef);
+    }
+
+    // the blocks that write each value, and those that read it before
+    // writing it, or at their end for a phi
+    int n = cfg.NumBlocks();
+    vector<vector<int> > defBlocks(NumValues()), useBlocks(NumValues());
+    vector<int> definedIn(NumValues(), -1);
+    for (int b = 0; b < n; b++) {
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            Operand uses[2];
+            int numUses = UsesOf(code[i], uses);
+            for (int k = 0; k < numUses; k++) {
+                int u = IndexOf(uses[k]);
+                if (u >= 0 && definedIn[u] != b && (useBlocks[u].empty() || useBlocks[u].back() != b))
+                    useBlocks[u].push_back(b);
+            }
+            int d = DefinesValue(code[i]) ? IndexOf(code[i].dst) : -1;
+            if (d >= 0 && definedIn[d] != b) {
+                definedIn[d] = b;
+                defBlocks[d].push_back(b);
+            }
+        }
+        exitUses.clear();
+        PhiUsesOnExit(code, cfg, b, exitUses);
+        for (int k = 0; k < exitUses.size(); k++) {
+            int u = IndexOf(exitUses[k]);
+            if (u >= 0 && definedIn[u] != b && (useBlocks[u].empty() || useBlocks[u].back() != b))
+                useBlocks[u].push_back(b);
+        }
+    }
+
+    // a value is live into the blocks reading it, and from there back up
+    // through every predecessor, out of all of them and into those that
+    // don't write it. Taking the values in order keeps the lists sorted.
+    liveIn.assign(n, vector<int>());
+    liveOut.assign(n, vector<int>());
+    vector<int> writes(n, -1), in(n, -1), out(n, -1);
+    vector<int> worklist;
+    for (int v = 0; v < NumValues(); v++) {
+        for (int k = 0; k < defBlocks[v].size(); k++)
+            writes[defBlocks[v][k]] = v;
+        worklist = useBlocks[v];
+        for (int k = 0; k < worklist.size(); k++) {
+            in[worklist[k]] = v;
+            liveIn[worklist[k]].push_back(v);
+        }
+        while (!worklist.empty()) {
+            int b = worklist.back();
+            worklist.pop_back();
+            const vector<int> &preds = cfg.blocks[b].preds;
+            for (int k = 0; k < preds.size(); k++) {
+                int p = preds[k];
+                if (out[p] == v)
+                    continue;
+                out[p] = v;
+                liveOut[p].push_back(v);
+                if (writes[p] != v && in[p] != v) {
+                    in[p] = v;
+                    liveIn[p].push_back(v);
+                    worklist.push_back(p);
+                }
+            }
+        }
+    }
+}
+
+bool Liveness::IsLiveIn(int b, int index) const {
+    return binary_search(liveIn[b].begin(), liveIn[b].end(), index);
+}
@@ -0,0 +1,77 @@
+/* File: liveness.h
+ * ----------------
+ * Liveness of values across the basic blocks of a function.
+ *
+ * Only values that can be live on entry to some block need to be tracked
+ * across blocks: ones that appear in more than one block, or are read in
+ * a block before being written there. Most temporaries are defined and
+ * used inside one block and never are. The tracked values get dense
+ * indices, and each one is followed backwards from the blocks that read
+ * it to the blocks that write it, so the sets come out as sorted lists
+ * of indices and the work is proportional to how much is live rather
+ * than to the number of blocks times the number of values, which in SSA
+ * form, with a value per definition, would be far too much. A pass
+ * walking a block backwards from liveOut finds the liveness of the
+ * others itself.
+ *
+ * Globals are left out too: a call or the end of the program can read
+ * any of them, so they are treated as always live.
+ *
+ * In SSA form a phi defines its value at the top of its block, and each
+ * of its arguments is read at the end of the matching predecessor.
+ */
+
+#ifndef _H_liveness
+#define _H_liveness
+
+#include "tac.h"
+#include "cfg.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class BitVector {
+  public:
+    BitVector(int n = 0) : words((n + 63) / 64, 0) {}
+
+    bool Test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void Set(int i)        { words[i >> 6] |= (uint64_t)1 << (i & 63); }
+    void Reset(int i)      { words[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+
+  private:
+    vector<uint64_t> words;
+};
+
+// The values an instruction reads and the one it writes, if any. A phi
+// reads nothing itself: its arguments are read on the way out of the
+// predecessors, see PhiUsesOnExit.
+int UsesOf(const TACObject &t, Operand uses[2]);
+bool DefinesValue(const TACObject &t);
+
+// Appends to uses the arguments block b passes to the phis of its
+// successors
+void PhiUsesOnExit(const vector<TACObject> &code, const CFG &cfg, int b, vector<Operand> &uses);
+
+class Liveness {
+  public:
+    vector<vector<int> > liveIn;    // per block, indices in increasing order
+    vector<vector<int> > liveOut;   // per block, likewise
+
+    Liveness(const vector<TACObject> &code, const CFG &cfg);
+
+    // Number of values live across blocks, and the dense index of one,
+    // or -1 for any other operand
+    int NumValues() const { return values.size(); }
+    int IndexOf(const Operand &o) const;
+    const Operand &ValueAt(int index) const { return values[index]; }
+    bool IsLiveIn(int b, int index) const;
+
+  private:
+    unordered_map<Operand, int, OperandHash> indices;
+    vector<Operand> values;
+
+    void AddIfLiveIn(const Operand &o, int b, const unordered_map<Operand, int, OperandHash> &lastDef);
+};
+
+#endif
@@ -0,0 +1,209 @@
+/* File: loops.cc
+ * --------------
+ * Implementation of the loop nesting analysis.
+ */
+
+#include "loops.h"
+#include "utility.h"
+#include <algorithm>
+#include <limits.h>
+
+// The outermost loop found so far around loop l, shortening the paths
+// on the way so that later lookups are quick
+static int Outermost(vector<int> &outer, int l) {
+    int root = l;
+    while (outer[root] != root)
+        root = outer[root];
+    while (outer[l] != root) {
+        int next = outer[l];
+        outer[l] = root;
+        l = next;
+    }
+    return root;
+}
+
+LoopInfo::LoopInfo(const CFG &cfg, const Dominators &dom)
+    : innermost(cfg.NumBlocks(), -1), maxDepth(0) {
+    // a header comes after the headers of the loops around it in reverse
+    // postorder, so going through that backwards finds inner loops first
+    vector<int> outer, work;
+    for (int k = (int)dom.reversePostorder.size() - 1; k >= 0; k--) {
+        int h = dom.reversePostorder[k];
+        const vector<int> &preds = cfg.blocks[h].preds;
+        Loop loop;
+        loop.header = h;
+        loop.parent = -1;
+        loop.depth = 0;
+        for (int p = 0; p < preds.size(); p++) {
+            if (dom.Dominates(h, preds[p]))
+                loop.latches.push_back(preds[p]);
+        }
+        if (loop.latches.empty())
+            continue;
+
+        int l = loops.size();
+        loops.push_back(loop);
+        outer.push_back(l);
+        innermost[h] = l;
+        work = loop.latches;
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            if (innermost[b] < 0) {
+                innermost[b] = l;
+                for (int p = 0; p < cfg.blocks[b].preds.size(); p++) {
+                    if (dom.IsReachable(cfg.blocks[b].preds[p]))
+                        work.push_back(cfg.blocks[b].preds[p]);
+                }
+                continue;
+            }
+            // b is in a loop already: that one, or the outermost one
+            // around it so far, is nested in this one, and the walk goes
+            // on from wherever it is entered
+            int inner = Outermost(outer, innermost[b]);
+            if (inner == l)
+                continue;
+            loops[inner].parent = l;
+            outer[inner] = l;
+            int innerHeader = loops[inner].header;
+            for (int p = 0; p < cfg.blocks[innerHeader].preds.size(); p++) {
+                int pred = cfg.blocks[innerHeader].preds[p];
+                if (dom.IsReachable(pred) && !dom.Dominates(innerHeader, pred))
+                    work.push_back(pred);
+            }
+        }
+    }
+
+    // the loops around one were found after it, so they are numbered higher
+    for (int l = (int)loops.size() - 1; l >= 0; l--) {
+        int parent = loops[l].parent;
+        loops[l].depth = parent < 0 ? 1 : loops[parent].depth + 1;
+        maxDepth = max(maxDepth, loops[l].depth);
+        if (parent < 0) {
+            roots.push_back(l);
+        }
+        else {
+            loops[parent].children.push_back(l);
+        }
+    }
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        for (int l = innermost[b]; l >= 0; l = loops[l].parent)
+            loops[l].blocks.push_back(b);
+    }
+}
+
+bool LoopInfo::Contains(int loop, int b) const {
+    const vector<int> &blocks = loops[loop].blocks;
+    return binary_search(blocks.begin(), blocks.end(), b);
+}
+
+vector<int> LoopInfo::Entries(const CFG &cfg, int loop) const {
+    const vector<int> &preds = cfg.blocks[loops[loop].header].preds;
+    vector<int> entries;
+    for (int k = 0; k < preds.size(); k++) {
+        if (!Contains(loop, preds[k]))
+            entries.push_back(preds[k]);
+    }
+    return entries;
+}
+
+int LoopInfo::Preheader(const CFG &cfg, int loop) const {
+    vector<int> entries = Entries(cfg, loop);
+    if (entries.size() != 1 || cfg.blocks[entries[0]].succs.size() != 1)
+        return -1;
+    return entries[0];
+}
+
+bool IsInvariant(const LoopInfo &loops, const vector<int> &blockOf, const DefUse &chains,
+                 int l, const Operand &o) {
+    if (o.IsConstant())
+        return true;
+    if (!o.IsValue() || o.IsGlobal())
+        return false;
+    for (int k = 0; k < chains.NumDefs(o); k++) {
+        if (loops.Contains(l, blockOf[chains.DefAt(o, k)]))
+            return false;
+    }
+    return true;
+}
+
+// The registers left over, in a loop as full as the passes may make it,
+// for the values that live inside one block of it
+static const int registersKept = 3;
+
+vector<int> LoopPressure(const LoopInfo &loops, const Liveness &liveness) {
+    vector<int> pressure(loops.loops.size(), 0);
+    for (int l = 0; l < loops.loops.size(); l++) {
+        const vector<int> &blocks = loops.loops[l].blocks;
+        for (int k = 0; k < blocks.size(); k++) {
+            int live = max(liveness.liveIn[blocks[k]].size(), liveness.liveOut[blocks[k]].size());
+            pressure[l] = max(pressure[l], live);
+        }
+    }
+    return pressure;
+}
+
+bool TakeRegister(const LoopInfo &loops, vector<int> &pressure, int loop) {
+    for (int m = loop; m >= 0; m = loops.loops[m].parent) {
+        if (pressure[m] + 1 > numAllocatableRegisters - registersKept)
+            return false;
+    }
+    for (int m = loop; m >= 0; m = loops.loops[m].parent)
+        pressure[m]++;
+    return true;
+}
+
+vector<int> BlockPressure(const Liveness &liveness) {
+    vector<int> pressure(liveness.liveIn.size());
+    for (int b = 0; b < pressure.size(); b++)
+        pressure[b] = max(liveness.liveIn[b].size(), liveness.liveOut[b].size());
+    return pressure;
+}
+
+bool TakeRegisterAcross(vector<int> &pressure, int first, int last) {
+    for (int b = first; b <= last; b++) {
+        if (pressure[b] + 1 > numAllocatableRegisters - registersKept)
+            return false;
+    }
+    for (int b = first; b <= last; b++)
+        pressure[b]++;
+    return true;
+}
+
+long long CountTrips(int op, long long first, long long step, long long bound) {
+    Operand enters;
+    FoldOperation(op, Operand::Int(first), Operand::Int(bound), enters);
+    long long trips;
+    if (enters.value == 0)
+        trips = 0;
+    else if (op == OP_Eq)
+        trips = step != 0 ? 1 : -1;
+    else if ((op == OP_Lt || op == OP_Le) && step > 0)
+        trips = (bound + (op == OP_Le) - first + step - 1) / step;
+    else if ((op == OP_Gt || op == OP_Ge) && step < 0)
+        trips = (first - bound + (op == OP_Ge) - step - 1) / -step;
+    else if (op == OP_Ne && step != 0 && (bound - first) % step == 0 && (bound - first) / step > 0)
+        trips = (bound - first) / step;
+    else
+        trips = -1;
+    long long last = first + trips * step;
+    return trips >= 0 && last >= INT_MIN && last <= INT_MAX ? trips : -1;
+}
+
+void ReportLoops(const vector<TACFunction*> &functions) {
+    if (!IsDebugOn("loops"))
+        return;
+    for (int f = 0; f < functions.size(); f++) {
+        if (functions[f]->IsTopLevel() || functions[f]->code.empty())
+            continue;
+        CFG cfg(functions[f]->code);
+        Dominators dom(cfg);
+        LoopInfo loops(cfg, dom);
+        int inLoops = 0;
+        for (int b = 0; b < cfg.NumBlocks(); b++)
+            inLoops += loops.LoopOf(b) >= 0 ? 1 : 0;
+        PrintDebug("loops", "%s: %d loops, nested %d deep, %d of %d blocks in loops",
+                   NameOf(functions[f]->name.value).c_str(), (int)loops.loops.size(),
+                   loops.MaxDepth(), inLoops, cfg.NumBlocks());
+    }
+}
@@ -0,0 +1,111 @@
+/* File: loops.h
+ * -------------
+ * The natural loops of a function and how they nest.
+ *
+ * An edge into a block that dominates its source is a back edge, and the
+ * block it goes to is the header of a loop made of the blocks that reach
+ * the back edge without going through the header. Back edges to the same
+ * header make one loop. Two loops are either disjoint or one is nested in
+ * the other, so together they form a forest.
+ *
+ * Headers are taken innermost first, so when a loop's body runs into a
+ * block that is already in a loop, the outermost loop found so far around
+ * that block is the one directly inside the new loop, and the walk goes
+ * on from that loop's entries instead of through its body again. Every
+ * block is walked over once per loop it is the header of, which keeps
+ * this linear in the size of the graph.
+ */
+
+#ifndef _H_loops
+#define _H_loops
+
+#include "cfg.h"
+#include "dominators.h"
+#include "liveness.h"
+#include "defuse.h"
+#include <vector>
+using namespace std;
+
+struct Loop {
+    int header;
+    int parent;                 // the loop directly around it, or -1
+    int depth;                  // 1 for an outermost loop
+    vector<int> latches;        // blocks with a back edge to the header
+    vector<int> blocks;         // all its blocks, nested loops' too, in
+                                // code order
+    vector<int> children;       // the loops directly inside it
+};
+
+class LoopInfo {
+  public:
+    vector<Loop> loops;         // inner loops before the ones around them
+    vector<int> roots;          // the outermost loops
+
+    LoopInfo(const CFG &cfg, const Dominators &dom);
+
+    // The innermost loop a block is in, or -1 outside of any
+    int LoopOf(int b) const { return innermost[b]; }
+    // How many loops a block is in; 0 outside of any
+    int Depth(int b) const { return innermost[b] < 0 ? 0 : loops[innermost[b]].depth; }
+    int MaxDepth() const { return maxDepth; }
+    bool Contains(int loop, int b) const;
+    // The blocks outside a loop that lead into its header
+    vector<int> Entries(const CFG &cfg, int loop) const;
+    // The one entry of a loop, if it leads nowhere else, or -1
+    int Preheader(const CFG &cfg, int loop) const;
+
+  private:
+    vector<int> innermost;
+    int maxDepth;
+};
+
+/* Function: IsInvariant
+ * ---------------------
+ * Whether o holds the same value all through loop l: a constant, or a
+ * local or temp none of whose writes is in the loop, blockOf giving the
+ * block of each instruction. A global is not, as a call may write it.
+ */
+bool IsInvariant(const LoopInfo &loops, const vector<int> &blockOf, const DefUse &chains,
+                 int l, const Operand &o);
+
+/* Function: LoopPressure, TakeRegister
+ * -------------------------------------
+ * LoopPressure gives, by loop, the most values live into or out of one
+ * of its blocks. A pass that makes a value live all through a loop, and
+ * maybe the loops around it, takes up a register in all of them, and
+ * TakeRegister allows that, counting it in, only while a few registers
+ * are left over for the values that live inside one block: there is no
+ * rematerialization, so a value left in memory costs more than it saves.
+ */
+vector<int> LoopPressure(const LoopInfo &loops, const Liveness &liveness);
+bool TakeRegister(const LoopInfo &loops, vector<int> &pressure, int loop);
+
+/* Function: BlockPressure, TakeRegisterAcross
+ * -------------------------------------------
+ * BlockPressure gives, by block, the values live into or out of it, the
+ * most of which over a loop's blocks is its LoopPressure. The backend
+ * keeps a value in a register over a stretch of code, so one kept from
+ * a block to a later one holds it in every block between them in code
+ * order, and TakeRegisterAcross allows that for the blocks from first to
+ * last, counting it in, under the same rule as TakeRegister.
+ */
+vector<int> BlockPressure(const Liveness &liveness);
+bool TakeRegisterAcross(vector<int> &pressure, int first, int last);
+
+/* Function: CountTrips
+ * --------------------
+ * How many trips a loop makes that goes on while its variable, starting
+ * at first and moving by step each trip, compares to bound as op says,
+ * or -1 if the loop never stops or the variable overflows on the way.
+ */
+long long CountTrips(int op, long long first, long long step, long long bound);
+
+/* Function: ReportLoops
+ * ---------------------
+ * Finds the loops of every function and prints (under the "loops" debug
+ * key) how many there are, how deep they nest and how many blocks are in
+ * some loop.
+ */
+void ReportLoops(const vector<TACFunction*> &functions);
+
+#endif
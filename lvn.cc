@@ -0,0 +1,174 @@
+/* File: lvn.cc
+ * ------------
+ * Implementation of local value numbering.
+ */
+
+#include "lvn.h"
+#include "liveness.h"
+#include "utility.h"
+#include <algorithm>
+#include <unordered_map>
+
+class ValueNumbering {
+  public:
+    // each instruction that recomputes a value, with the operand holding
+    // it at that point
+    vector<pair<int, Operand> > redundant;
+
+    ValueNumbering(const vector<TACObject> &code) : code(code), block(0), calls(0) {}
+    void NumberBlock(const BasicBlock &b);
+
+  private:
+    // A number is only good in the block it was given in, and for a
+    // global, until the next call; these count both, so that nothing has
+    // to be cleared between blocks
+    struct Number {
+        int value, block, calls;
+
+        Number() : value(-1), block(-1), calls(-1) {}
+    };
+    const vector<TACObject> &code;
+    int block, calls;
+    vector<Number> ofSlot;                          // locals and temps
+    unordered_map<int, Number> ofGlobal;            // by global slot
+    unordered_map<Operand, int, OperandHash> ofConstant;
+    unordered_map<long long, int> ofOperation;
+    vector<Operand> holder;     // by number, the operand given it last
+
+    Number *Find(const Operand &o);
+    int NumberOf(const Operand &o);
+    bool Holds(const Operand &o, int value);
+    void Give(const Operand &o, int value);
+};
+
+// Where the number of a value is kept
+ValueNumbering::Number *ValueNumbering::Find(const Operand &o) {
+    if (o.IsGlobal())
+        return &ofGlobal[o.slot];
+    if (o.slot >= ofSlot.size())
+        ofSlot.resize(o.slot + 1);
+    return &ofSlot[o.slot];
+}
+
+bool ValueNumbering::Holds(const Operand &o, int value) {
+    if (o.IsConstant())
+        return true;
+    Number *n = Find(o);
+    return n->value == value && n->block == block && (!o.IsGlobal() || n->calls == calls);
+}
+
+void ValueNumbering::Give(const Operand &o, int value) {
+    Number *n = Find(o);
+    n->value = value;
+    n->block = block;
+    n->calls = calls;
+    if (!Holds(holder[value], value))
+        holder[value] = o;
+}
+
+// The number of what o holds, giving it a new one if it has none yet
+int ValueNumbering::NumberOf(const Operand &o) {
+    if (o.IsConstant()) {
+        unordered_map<Operand, int, OperandHash>::iterator it = ofConstant.find(o);
+        if (it != ofConstant.end())
+            return it->second;
+        ofConstant[o] = holder.size();
+        holder.push_back(o);
+        return holder.size() - 1;
+    }
+    Number *n = Find(o);
+    if (n->value >= 0 && Holds(o, n->value))
+        return n->value;
+    holder.push_back(o);
+    Give(o, holder.size() - 1);
+    return holder.size() - 1;
+}
+
+void ValueNumbering::NumberBlock(const BasicBlock &b) {
+    block++;
+    for (int i = b.begin; i < b.end; i++) {
+        const TACObject &t = code[i];
+        if (t.type == TAC_Call)
+            calls++;
+        if (!DefinesValue(t))
+            continue;
+
+        int value = -1;
+        if (t.type == TAC_Assign) {
+            value = NumberOf(t.src1);
+        }
+        else if (t.type == TAC_BinaryOp) {
+            long long left = NumberOf(t.src1), right = NumberOf(t.src2);
+            int op = t.ops;
+            if (left > right && SwappedOperator(op) != OP_None) {
+                swap(left, right);
+                op = SwappedOperator(op);
+            }
+            long long key = ((long long)op << 56) | (left << 28) | right;
+            unordered_map<long long, int>::iterator it = ofOperation.find(key);
+            if (it == ofOperation.end()) {
+                value = holder.size();
+                holder.push_back(t.dst);
+                ofOperation[key] = value;
+            }
+            else {
+                value = it->second;
+            }
+        }
+        if (value < 0) {
+            // a call, parameter or phi: nothing else holds its value
+            value = holder.size();
+            holder.push_back(t.dst);
+        }
+        else if (Holds(t.dst, value)) {
+            redundant.push_back(make_pair(i, t.dst));
+            continue;
+        }
+        else if (t.type == TAC_BinaryOp && Holds(holder[value], value)) {
+            redundant.push_back(make_pair(i, holder[value]));
+        }
+        Give(t.dst, value);
+    }
+}
+
+bool LocalValueNumbering(TACFunction *fn, AnalysisManager &analyses) {
+    vector<TACObject> &code = fn->code;
+    const CFG &cfg = analyses.GetCFG();
+    ValueNumbering numbering(code);
+    for (int b = 0; b < cfg.NumBlocks(); b++)
+        numbering.NumberBlock(cfg.blocks[b]);
+
+    int found = 0, temps = 0, removed = 0;
+    const vector<pair<int, Operand> > &redundant = numbering.redundant;
+    if (!redundant.empty()) {
+        DefUse &chains = analyses.GetDefUse();
+        for (int k = 0; k < redundant.size(); k++) {
+            int i = redundant[k].first;
+            Operand dst = code[i].dst, with = redundant[k].second;
+            // an operation only copied is computed straight into the
+            // copy, which reading with instead would still need
+            if (dst != with && chains.NumUses(dst) == 1 &&
+                code[chains.UseAt(dst, 0).instr].type == TAC_Assign)
+                continue;
+            found++;
+            if (dst == with) {
+                chains.Erase(i);
+            }
+            else if (chains.NumDefs(dst) == 1 && chains.NumDefs(with) == 1) {
+                // with is written once, before dst in this block, so
+                // the two hold the same value wherever dst is read
+                chains.ReplaceAllUsesWith(dst, with);
+                chains.Erase(i);
+                temps += dst.IsTemp() ? 1 : 0;
+            }
+            else {
+                chains.Replace(i, NewCopy(dst, with));
+            }
+        }
+        removed = chains.Compact();
+    }
+    PrintDebug("lvn", "%s: %d operations and copies redundant, %d instructions and %d "
+               "temporaries saved", fn->IsTopLevel() ? "(top level)" : NameOf(fn->name.value).c_str(),
+               found, removed, temps);
+    return found > 0;
+}
@@ -0,0 +1,35 @@
+/* File: lvn.h
+ * -----------
+ * Local value numbering over one function's TAC.
+ *
+ * The code generator gives every operation a fresh temporary, so an
+ * expression written twice in a block is computed twice. Walking each
+ * block in order, every value an operand holds gets a number: a copy
+ * passes the number of its source on, and an operation on numbers seen
+ * together before gets the number they got then, with the operands of
+ * commutative operators, and of > and >= turned around, put in one
+ * order. An operation whose number some operand still holds recomputes
+ * that operand. Writing an operand takes its old number away from it,
+ * and a call does so for every global.
+ */
+
+#ifndef _H_lvn
+#define _H_lvn
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: LocalValueNumbering
+ * -----------------------------
+ * Removes the operations and copies that recompute a value an operand
+ * still holds, through the def-use chains. A temporary written once is
+ * replaced everywhere by an operand that is also written once and holds
+ * the same value; any other destination gets a copy of that operand. An
+ * operation whose result is only copied is left, as the backend computes
+ * it straight into the copy. Works in place and returns whether anything changed. The "lvn" debug
+ * key prints, for each function, how many operations were found
+ * redundant and how many instructions and temporaries that saved.
+ */
+bool LocalValueNumbering(TACFunction *fn, AnalysisManager &analyses);
+
+#endif
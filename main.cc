@@ -9,6 +9,7 @@
 #include "utility.h"
 #include "errors.h"
 #include "parser.h"
+#include "output.h"
 
 
 /* Function: main()
@@ -22,9 +23,11 @@
 int main(int argc, char *argv[])
 {
     ParseCommandLine(argc, argv);
+    OpenOutput(GetOutputFileName());
     InitLexer();
     InitParser();
     yyparse();
+    CloseOutput();
     return (ReportError::NumErrors() == 0? 0 : -1);
 }
 
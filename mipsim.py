@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+#
+# Runs the MIPS the compiler emits, for test.sh and bench.sh: the subset
+# of instructions and syscalls the backend uses, with integer input taken
+# from the command line.
+#
+# Usage: ./mipsim.py file.s [int ...]
+#   prints what the program prints, and "#insns N", the number of
+#   instructions executed, on stderr; exits with an error message on an
+#   unsupported instruction, a division by zero, a signed overflow in add
+#   or sub, which trap on the machine, or running out of input
+import sys, re
+
+def parse(path):
+    text = open(path).read()
+    if '=================================' in text:
+        text = text.split('=================================', 1)[1]
+    insns, labels, data, dlabels = [], {}, {}, {}
+    seg = 'text'
+    daddr = 0x10010000
+    for raw in text.split('\n'):
+        line = raw.split('#', 1)[0].strip()
+        if not line:
+            continue
+        while True:
+            m = re.match(r'^([A-Za-z_.$][\w.$]*):\s*(.*)$', line)
+            if not m:
+                break
+            if seg == 'text':
+                labels[m.group(1)] = len(insns)
+            else:
+                dlabels[m.group(1)] = daddr
+            line = m.group(2).strip()
+        if not line:
+            continue
+        if line.startswith('.'):
+            parts = line.split(None, 1)
+            d = parts[0]
+            if d == '.data':
+                seg = 'data'
+            elif d == '.text':
+                seg = 'text'
+            elif d == '.word':
+                for v in parts[1].split(','):
+                    data[daddr] = int(v.strip(), 0)
+                    daddr += 4
+            elif d == '.space':
+                n = int(parts[1])
+                for k in range(0, n, 4):
+                    data[daddr + k] = 0
+                daddr += n
+            continue
+        parts = line.split(None, 1)
+        op = parts[0]
+        args = [a.strip() for a in parts[1].split(',')] if len(parts) > 1 else []
+        insns.append((op, args, raw.strip()))
+    return insns, labels, data, dlabels
+
+REGN = {'zero': 0, 'at': 1, 'v0': 2, 'v1': 3, 'a0': 4, 'a1': 5, 'a2': 6, 'a3': 7,
+        't0': 8, 't1': 9, 't2': 10, 't3': 11, 't4': 12, 't5': 13, 't6': 14, 't7': 15,
+        's0': 16, 's1': 17, 's2': 18, 's3': 19, 's4': 20, 's5': 21, 's6': 22, 's7': 23,
+        't8': 24, 't9': 25, 'k0': 26, 'k1': 27, 'gp': 28, 'sp': 29, 'fp': 30, 's8': 30, 'ra': 31}
+
+def s32(v):
+    v &= 0xffffffff
+    return v - (1 << 32) if v & 0x80000000 else v
+
+def run(path, inputs, limit=50_000_000):
+    insns, labels, data, dlabels = parse(path)
+    R = [0] * 32
+    R[29] = 0x7fffeffc
+    R[31] = -1
+    mem = dict(data)
+    out = []
+    inp = list(inputs)
+
+    def reg(a):
+        a = a.strip()
+        assert a.startswith('$'), a
+        n = a[1:]
+        return int(n) if n.isdigit() else REGN[n]
+
+    def val(a):
+        a = a.strip()
+        if a.startswith('$'):
+            return R[reg(a)]
+        if a in dlabels:
+            return dlabels[a]
+        return int(a, 0)
+
+    def addr(a):
+        m = re.match(r'^(-?\w*)\((\$\w+)\)$', a.strip())
+        if m:
+            off = int(m.group(1), 0) if m.group(1) else 0
+            return R[reg(m.group(2))] + off
+        m = re.match(r'^(\w+)\+(\d+)$', a.strip())
+        if m:
+            return dlabels[m.group(1)] + int(m.group(2))
+        return dlabels[a.strip()]
+
+    pc = labels.get('main', 0)
+    count = 0
+    while 0 <= pc < len(insns):
+        count += 1
+        if count > limit:
+            raise SystemExit('instruction limit exceeded')
+        op, a, raw = insns[pc]
+        npc = pc + 1
+        def setr(x, v):
+            r = reg(x)
+            if r != 0:
+                R[r] = s32(v)
+        def target(l):
+            if l not in labels:
+                raise SystemExit('unknown label %s' % l)
+            return labels[l]
+        if op == 'li' or op == 'la':
+            setr(a[0], val(a[1]))
+        elif op == 'move':
+            setr(a[0], val(a[1]))
+        elif op == 'lw':
+            ad = addr(a[1])
+            assert ad % 4 == 0, raw
+            setr(a[0], mem.get(ad, 0))
+        elif op == 'sw':
+            ad = addr(a[1])
+            assert ad % 4 == 0, raw
+            mem[ad] = s32(val(a[0]))
+        elif op in ('add', 'addi', 'sub'):
+            v = val(a[1]) + val(a[2]) if op != 'sub' else val(a[1]) - val(a[2])
+            if v != s32(v):
+                raise SystemExit('arithmetic overflow: %s' % raw)
+            setr(a[0], v)
+        elif op in ('addu', 'addiu'):
+            setr(a[0], val(a[1]) + val(a[2]))
+        elif op == 'subu':
+            setr(a[0], val(a[1]) - val(a[2]))
+        elif op in ('mul', 'mulo'):
+            setr(a[0], val(a[1]) * val(a[2]))
+        elif op == 'div' and len(a) == 3:
+            x, y = val(a[1]), val(a[2])
+            if y == 0:
+                raise SystemExit('division by zero')
+            q = abs(x) // abs(y)
+            setr(a[0], q if (x < 0) == (y < 0) else -q)
+        elif op == 'rem':
+            x, y = val(a[1]), val(a[2])
+            q = abs(x) // abs(y)
+            q = q if (x < 0) == (y < 0) else -q
+            setr(a[0], x - q * y)
+        elif op == 'neg':
+            setr(a[0], -val(a[1]))
+        elif op == 'slt' or op == 'slti':
+            setr(a[0], 1 if val(a[1]) < val(a[2]) else 0)
+        elif op == 'sle':
+            setr(a[0], 1 if val(a[1]) <= val(a[2]) else 0)
+        elif op == 'sgt':
+            setr(a[0], 1 if val(a[1]) > val(a[2]) else 0)
+        elif op == 'sge':
+            setr(a[0], 1 if val(a[1]) >= val(a[2]) else 0)
+        elif op == 'seq':
+            setr(a[0], 1 if val(a[1]) == val(a[2]) else 0)
+        elif op == 'sne':
+            setr(a[0], 1 if val(a[1]) != val(a[2]) else 0)
+        elif op in ('and', 'andi'):
+            setr(a[0], val(a[1]) & val(a[2]))
+        elif op in ('or', 'ori'):
+            setr(a[0], val(a[1]) | val(a[2]))
+        elif op in ('xor', 'xori'):
+            setr(a[0], val(a[1]) ^ val(a[2]))
+        elif op == 'sll':
+            setr(a[0], val(a[1]) << val(a[2]))
+        elif op == 'sra':
+            setr(a[0], val(a[1]) >> val(a[2]))
+        elif op in ('beq', 'bne', 'blt', 'bgt', 'ble', 'bge'):
+            x, y = val(a[0]), val(a[1])
+            c = {'beq': x == y, 'bne': x != y, 'blt': x < y, 'bgt': x > y, 'ble': x <= y, 'bge': x >= y}[op]
+            if c:
+                npc = target(a[2])
+        elif op in ('beqz', 'bnez', 'bltz', 'bgtz', 'blez', 'bgez'):
+            x = val(a[0])
+            c = {'beqz': x == 0, 'bnez': x != 0, 'bltz': x < 0, 'bgtz': x > 0, 'blez': x <= 0, 'bgez': x >= 0}[op]
+            if c:
+                npc = target(a[1])
+        elif op in ('j', 'b'):
+            npc = target(a[0])
+        elif op == 'jal':
+            R[31] = pc + 1
+            npc = target(a[0])
+        elif op == 'jr':
+            npc = R[reg(a[0])]
+            if npc == -1:
+                break
+        elif op == 'syscall':
+            v0 = R[2]
+            if v0 == 1:
+                out.append(str(R[4]))
+            elif v0 == 11:
+                out.append(chr(R[4]))
+            elif v0 == 5:
+                if not inp:
+                    raise SystemExit('input exhausted')
+                R[2] = int(inp.pop(0))
+            elif v0 == 10:
+                break
+            else:
+                raise SystemExit('unsupported syscall %d' % v0)
+        elif op == 'nop':
+            pass
+        else:
+            raise SystemExit('unsupported op %s' % raw)
+        pc = npc
+    return ''.join(out), count
+
+if __name__ == '__main__':
+    o, n = run(sys.argv[1], sys.argv[2:])
+    sys.stdout.write(o + '\n')
+    sys.stderr.write('#insns %d\n' % n)
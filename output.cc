@@ -0,0 +1,67 @@
+/* File: output.cc
+ * ---------------
+ * Implementation of the buffered output sink.
+ */
+
+#include "output.h"
+#include "utility.h"
+#include <stdio.h>
+
+// A streambuf that fills a fixed buffer and passes it to a FILE whole
+class OutputBuffer : public streambuf {
+  public:
+    static const int BufferSize = 1 << 16;
+
+    OutputBuffer() : file(stdout) { setp(buffer, buffer + BufferSize); }
+    void SetFile(FILE *f) { file = f; }
+    FILE *GetFile() { return file; }
+
+  protected:
+    int overflow(int c) {
+        if (sync() != 0)
+            return traits_type::eof();
+        if (c != traits_type::eof()) {
+            *pptr() = c;
+            pbump(1);
+        }
+        return c;
+    }
+
+    int sync() {
+        size_t n = pptr() - pbase();
+        if (n > 0 && fwrite(pbase(), 1, n, file) != n)
+            return -1;
+        setp(buffer, buffer + BufferSize);
+        return 0;
+    }
+
+  private:
+    FILE *file;
+    char buffer[BufferSize];
+};
+
+static OutputBuffer outputBuffer;
+static ostream outputStream(&outputBuffer);
+
+void OpenOutput(const char *filename) {
+    FILE *f = stdout;
+    if (filename) {
+        f = fopen(filename, "w");
+        if (f == NULL)
+            Failure("Cannot open output file %s", filename);
+    }
+    outputBuffer.SetFile(f);
+}
+
+ostream &Output() {
+    return outputStream;
+}
+
+void CloseOutput() {
+    outputStream.flush();
+    FILE *f = outputBuffer.GetFile();
+    if (f != stdout)
+        fclose(f);
+    else
+        fflush(f);
+}
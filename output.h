@@ -0,0 +1,39 @@
+/* File: output.h
+ * --------------
+ * The sink that the generated TAC and MIPS are written to: stdout, or the
+ * file given with -o. Text is collected in a large buffer and handed to
+ * the file in big blocks, so write line ends as '\n' rather than endl,
+ * which would flush.
+ */
+
+#ifndef _H_output
+#define _H_output
+
+#include <iostream>
+using namespace std;
+
+/**
+ * Function: OpenOutput()
+ * Usage: OpenOutput("out.s");
+ * ---------------------------
+ * Directs Output() to the named file, or to stdout if the name is NULL.
+ * Reports a failure if the file cannot be created.
+ */
+void OpenOutput(const char *filename);
+
+/**
+ * Function: Output()
+ * Usage: Output() << "    jr $ra" << '\n';
+ * ----------------------------------------
+ * The stream to write generated code to.
+ */
+ostream &Output();
+
+/**
+ * Function: CloseOutput()
+ * -----------------------
+ * Writes out whatever is still buffered and closes the output file.
+ */
+void CloseOutput();
+
+#endif
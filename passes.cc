@@ -0,0 +1,166 @@
+/* File: passes.cc
+ * ---------------
+ * Implementation of the pass manager.
+ */
+
+#include "passes.h"
+#include "ast.h"
+#include "sccp.h"
+#include "ssa.h"
+#include "lvn.h"
+#include "gvn.h"
+#include "licm.h"
+#include "ivs.h"
+#include "scev.h"
+#include "utility.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+static bool RunFold(TACFunction *fn, AnalysisManager &analyses) {
+    return constantFolding(fn->code, analyses);
+}
+static bool RunSCCP(TACFunction *fn, AnalysisManager &analyses) {
+    return constantPropagation(fn->code, analyses);
+}
+static bool RunDCE(TACFunction *fn, AnalysisManager &analyses) {
+    return deadCodeElimination(fn->code, analyses);
+}
+
+// ssa and gvn only add instructions inside blocks and rename operands,
+// and so do ivs, which also removes some, and scev, which rewrites some;
+// lvn and fold rewrite and remove instructions but never a jump or
+// label, and lvn does it through the def-use chains; licm adds blocks
+// and moves instructions from one to another; dce deletes through the
+// def-use chains and recomputes the rest of what it asks for after every
+// round that removes something
+static const Pass passes[] = {
+    { "ssa",  BuildSSA, ANALYSIS_CFG | ANALYSIS_Dominators | ANALYSIS_Loops },
+    { "fold", RunFold,  ANALYSIS_Dominators | ANALYSIS_Loops },
+    { "sccp", RunSCCP,  ANALYSIS_None },
+    { "lvn",  LocalValueNumbering, ANALYSIS_Dominators | ANALYSIS_Loops | ANALYSIS_DefUse },
+    { "gvn",  GlobalValueNumbering, ANALYSIS_Dominators | ANALYSIS_Loops },
+    { "licm", LoopInvariantCodeMotion, ANALYSIS_None },
+    { "ivs",  ReduceInductionVariables, ANALYSIS_Dominators | ANALYSIS_Loops },
+    { "scev", EvaluateCountedLoops, ANALYSIS_Dominators | ANALYSIS_Loops },
+    { "dce",  RunDCE,   ANALYSIS_All },
+};
+static const int numPasses = sizeof(passes) / sizeof(passes[0]);
+
+// The pipeline of each -O level; -O3 also runs it to a fixed point.
+// scev and ivs pay for what they set up before a loop over its trips,
+// so they are left to -O3, and -O2 never runs more than -O1 does.
+static const char *levelPipelines[] = { "", "lvn,dce", "ssa,sccp,lvn,gvn,licm,dce",
+                                      "ssa,scev,sccp,lvn,gvn,licm,ivs,fold,dce" };
+
+// A round of a fixed-point pipeline that still changes the code after
+// this many rounds is cut off there
+static const int maxRounds = 10;
+
+static const Pass *LookupPass(const string &name) {
+    for (int p = 0; p < numPasses; p++) {
+        if (name == passes[p].name)
+            return &passes[p];
+    }
+    return NULL;
+}
+
+// Splits a comma-separated list of pass names, giving up on an unknown one
+static vector<const Pass*> ParsePipeline(const char *list) {
+    vector<const Pass*> pipeline;
+    string names(list);
+    size_t start = 0;
+    while (start < names.size()) {
+        size_t comma = names.find(',', start);
+        if (comma == string::npos)
+            comma = names.size();
+        string name = names.substr(start, comma - start);
+        if (!name.empty()) {
+            const Pass *pass = LookupPass(name);
+            if (pass == NULL) {
+                fprintf(stderr, "Unknown pass '%s'; the passes are:", name.c_str());
+                for (int p = 0; p < numPasses; p++)
+                    fprintf(stderr, " %s", passes[p].name);
+                fprintf(stderr, "\n");
+                exit(2);
+            }
+            pipeline.push_back(pass);
+        }
+        start = comma + 1;
+    }
+    return pipeline;
+}
+
+// Totals for one pass of the pipeline over all functions
+struct PassStats {
+    int runs;
+    long removed;
+    double ms;
+    long hits, requests;        // analyses asked for and found cached
+
+    PassStats() : runs(0), removed(0), ms(0), hits(0), requests(0) {}
+};
+
+static double MillisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void RunPasses(const vector<TACFunction*> &functions) {
+    const char *list = GetPassList();
+    vector<const Pass*> pipeline = ParsePipeline(list ? list : levelPipelines[GetOptLevel()]);
+    bool fixedPoint = GetFixedPoint() || (list == NULL && GetOptLevel() == 3);
+    if (pipeline.empty())
+        return;
+
+    vector<PassStats> stats(pipeline.size());
+    long before = 0, after = 0;
+    int mostRounds = 0;
+    long hits = 0, requests = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int f = 0; f < functions.size(); f++) {
+        vector<TACObject> &code = functions[f]->code;
+        AnalysisManager analyses(code);
+        before += code.size();
+        int rounds = 0;
+        bool changed = true;
+        while (changed && rounds < (fixedPoint ? maxRounds : 1)) {
+            changed = false;
+            for (int p = 0; p < pipeline.size(); p++) {
+                chrono::steady_clock::time_point passStart = chrono::steady_clock::now();
+                int size = code.size();
+                int hitsBefore = analyses.hits, missesBefore = analyses.misses;
+                if (pipeline[p]->run(functions[f], analyses)) {
+                    analyses.Invalidate(pipeline[p]->preserves);
+                    changed = true;
+                }
+                stats[p].ms += MillisecondsSince(passStart);
+                stats[p].removed += size - (int)code.size();
+                stats[p].runs++;
+                stats[p].hits += analyses.hits - hitsBefore;
+                stats[p].requests += analyses.hits - hitsBefore + analyses.misses - missesBefore;
+            }
+            rounds++;
+        }
+        after += code.size();
+        mostRounds = max(mostRounds, rounds);
+        hits += analyses.hits;
+        requests += analyses.hits + analyses.misses;
+    }
+    double ms = MillisecondsSince(start);
+
+    if (!IsDebugOn("passes"))
+        return;
+    for (int p = 0; p < pipeline.size(); p++) {
+        PrintDebug("passes", "%s: %.1f ms, %ld instructions removed, run %d times, "
+                   "%ld of %ld analyses cached", pipeline[p]->name, stats[p].ms,
+                   stats[p].removed, stats[p].runs, stats[p].hits, stats[p].requests);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    PrintDebug("passes", "total: %ld -> %ld instructions, %.1f ms, at most %d rounds, "
+               "peak RSS %ld KB", before, after, ms, mostRounds, (long)usage.ru_maxrss);
+    PrintDebug("passes", "analyses: %ld of %ld cached, %.0f%% hit rate", hits, requests,
+               requests ? 100.0 * hits / requests : 0.0);
+}
@@ -0,0 +1,67 @@
+/* File: passes.h
+ * --------------
+ * The optimization pass manager.
+ *
+ * A pass rewrites one function in place and returns whether it changed
+ * anything; deleted instructions are marked and swept once per pass, so
+ * no pass ever copies the code. A pipeline is a list of
+ * passes run in order over every function, and can be repeated until a
+ * whole round leaves the code unchanged. Each -O level names a pipeline,
+ * and --passes= replaces it with any other list of the registered
+ * passes:
+ *
+ *    ssa     BuildSSA: puts the function into SSA form, which it stays
+ *            in until the backend takes it out again
+ *    fold    constantFolding: folds operations on constants and merges
+ *            the copy of the result that follows into them
+ *    sccp    constantPropagation: sparse conditional constant
+ *            propagation, removing unreachable code
+ *    lvn     LocalValueNumbering: reuses values already computed in the
+ *            same block
+ *    gvn     GlobalValueNumbering: removes operations computed on every
+ *            path, or on all but one, to them, placing phis and copies
+ *    licm    LoopInvariantCodeMotion: hoists invariant code into loop
+ *            preheaders and keeps globals in locals through loops
+ *    ivs     ReduceInductionVariables: turns multiplies of induction
+ *            variables into additions and the variables' tests into
+ *            tests of the products, in SSA form only
+ *    scev    EvaluateCountedLoops: starts loops that only compute values
+ *            at the values they leave with, worked out in closed form,
+ *            so they make no trips, in SSA form only
+ *    dce     deadCodeElimination: liveness-based dead code elimination
+ *
+ * The other passes work on code in SSA form or not alike.
+ *
+ * The passes get the CFG, dominators, loops, liveness and def-use chains
+ * of a function from an AnalysisManager kept for it across the whole
+ * pipeline, and each pass declares which of them it leaves valid when it
+ * changes the code; a pass that changes nothing leaves them all valid.
+ */
+
+#ifndef _H_passes
+#define _H_passes
+
+#include "tac.h"
+#include "analyses.h"
+#include <vector>
+using namespace std;
+
+typedef bool (*PassFunction)(TACFunction *fn, AnalysisManager &analyses);
+
+struct Pass {
+    const char *name;
+    PassFunction run;
+    int preserves;              // ANALYSIS_ flags still valid after a change
+};
+
+/* Function: RunPasses
+ * -------------------
+ * Runs the pipeline chosen on the command line over every function. Under
+ * the "passes" debug key it prints, for each pass, how often it ran, the
+ * wall time it took, how many instructions it removed and how many of
+ * the analyses it asked for were cached, summed over all the functions,
+ * and the same for the pipeline as a whole.
+ */
+void RunPasses(const vector<TACFunction*> &functions);
+
+#endif
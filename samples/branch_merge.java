@@ -0,0 +1,24 @@
+void main() {
+    int a;
+    int b;
+    int c;
+    a = readIntFromSTDIN();
+    b = 1;
+    c = 5;
+    if (a > 3) {
+        b = 2;
+    }
+    printInt(b);
+    if (a > 10) {
+        c = 6;
+    } else {
+        b = b + c;
+    }
+    printInt(b);
+    while (a > 0) {
+        b = b * 2;
+        a = a - 1;
+    }
+    printInt(b);
+    printInt(c);
+}
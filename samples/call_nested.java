@@ -0,0 +1,17 @@
+int add(int a, int b) {
+    return a + b;
+}
+
+int six(int a, int b, int c, int d, int e, int f) {
+    return a + b + c + d + e + f;
+}
+
+void main() {
+    int x;
+    int r;
+    x = 5;
+    r = add(x, (add(2, 3)));
+    printInt(r);
+    r = six(x, x, (add(x, 1)), 4, 5, 6);
+    printInt(r);
+}
@@ -0,0 +1,23 @@
+int g;
+
+int f(int x) {
+    g = g + x;
+    return x;
+}
+
+void main() {
+    int a;
+    int b;
+    int c;
+    int d;
+    int e;
+    a = readIntFromSTDIN();
+    b = readIntFromSTDIN();
+    c = a * b + g;
+    d = b * a + g;
+    e = f(a);
+    e = e + a * b + g;
+    printInt(c);
+    printInt(d);
+    printInt(e);
+}
@@ -0,0 +1,21 @@
+void main() {
+    int a;
+    int b;
+    int c;
+    int n;
+    n = readIntFromSTDIN();
+    a = 4;
+    if (a > 3) {
+        b = 10;
+    } else {
+        b = n;
+    }
+    c = n * 0;
+    c = c + (n + 0);
+    while (a < 10) {
+        a = a + 2;
+    }
+    printInt(b);
+    printInt(c);
+    printInt(a);
+}
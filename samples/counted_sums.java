@@ -0,0 +1,17 @@
+void main() {
+    int i;
+    int n;
+    int sum;
+    int d;
+    n = readIntFromSTDIN();
+    sum = 0;
+    for (i = 1; i <= n; i = i + 1) {
+        sum = sum + i;
+    }
+    printInt(sum);
+    d = 0;
+    for (i = n; i > 0; i = i - 1) {
+        d = d + 2;
+    }
+    printInt(d);
+}
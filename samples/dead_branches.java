@@ -0,0 +1,13 @@
+void main() {
+    int a;
+    int b;
+    int n;
+    n = readIntFromSTDIN();
+    if (n > 0) {
+        a = n * 3;
+    } else {
+        a = n - 1;
+    }
+    b = a + 1;
+    printInt(n);
+}
@@ -0,0 +1,19 @@
+void main() {
+    int a;
+    int b;
+    int c;
+    int d;
+    int y;
+    a = readIntFromSTDIN();
+    b = readIntFromSTDIN();
+    d = (a - b) * 2;
+    if (a > b) {
+        c = (a + b) * 2;
+    } else {
+        c = (a - b) * 5;
+    }
+    y = (a + b) * 3;
+    printInt(c);
+    printInt(d);
+    printInt(y);
+}
@@ -0,0 +1,28 @@
+int counter;
+int total;
+
+void bump(int by) {
+    counter = counter + 1;
+    total = total + by;
+}
+
+int sum7(int a, int b, int c, int d, int e, int f, int g) {
+    bump(g);
+    return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + g * 7;
+}
+
+void main() {
+    int i;
+    int r;
+    counter = 0;
+    total = 0;
+    for (i = 0; i < 5; i = i + 1) {
+        bump(i);
+        total = total + counter;
+    }
+    printInt(counter);
+    printInt(total);
+    r = sum7(1, 2, 3, 4, 5, 6, counter);
+    printInt(r);
+    printInt(total);
+}
@@ -0,0 +1,17 @@
+int total;
+
+void main() {
+    int i;
+    int n;
+    int k;
+    int s;
+    n = readIntFromSTDIN();
+    k = readIntFromSTDIN();
+    s = 0;
+    for (i = 0; i < n; i = i + 1) {
+        s = s + k * k;
+        total = total + i;
+    }
+    printInt(s);
+    printInt(total);
+}
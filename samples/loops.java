@@ -0,0 +1,31 @@
+void main() {
+    int n;
+    int i;
+    int j;
+    int s;
+    int t;
+    n = readIntFromSTDIN();
+    s = 0;
+    for (i = 0; i < n; i = i + 1) {
+        for (j = i; j < n; j = j + 1) {
+            s = s + i * j;
+        }
+    }
+    printInt(s);
+    t = 0;
+    i = n;
+    while (i > 3) {
+        if (i == 7) {
+            t = t - 100;
+        } else {
+            t = t + i;
+        }
+        i = i - 1;
+    }
+    printInt(t);
+    j = 1;
+    while (j < 1000) {
+        j = j * 2;
+    }
+    printInt(j);
+}
@@ -0,0 +1,44 @@
+int fact(int n) {
+    int r;
+    if (n <= 1) {
+        return 1;
+    }
+    r = fact((n - 1));
+    return n * r;
+}
+
+int fib(int n) {
+    int a;
+    int b;
+    if (n < 2) {
+        return n;
+    }
+    a = fib((n - 1));
+    b = fib((n - 2));
+    return a + b;
+}
+
+int ackermann(int m, int n) {
+    int r;
+    if (m == 0) {
+        return n + 1;
+    }
+    if (n == 0) {
+        r = ackermann((m - 1), 1);
+        return r;
+    }
+    r = ackermann((m - 1), (ackermann(m, (n - 1))));
+    return r;
+}
+
+void main() {
+    int n;
+    int r;
+    n = readIntFromSTDIN();
+    r = fact(n);
+    printInt(r);
+    r = fib((n + 5));
+    printInt(r);
+    r = ackermann(2, n);
+    printInt(r);
+}
@@ -0,0 +1,62 @@
+void main() {
+    int a0;
+    int a1;
+    int a2;
+    int a3;
+    int a4;
+    int a5;
+    int a6;
+    int a7;
+    int a8;
+    int a9;
+    int a10;
+    int a11;
+    int a12;
+    int a13;
+    int a14;
+    int a15;
+    int i;
+    int j;
+    int n;
+    int s;
+    n = readIntFromSTDIN();
+    a0 = n + 1;
+    a1 = n + 2;
+    a2 = n + 3;
+    a3 = n + 4;
+    a4 = n + 5;
+    a5 = n + 6;
+    a6 = n + 7;
+    a7 = n + 8;
+    a8 = n + 9;
+    a9 = n + 10;
+    a10 = n + 11;
+    a11 = n + 12;
+    a12 = n + 13;
+    a13 = n + 14;
+    a14 = n + 15;
+    a15 = n + 16;
+    s = 0;
+    for (i = 0; i < n; i = i + 1) {
+        for (j = 0; j < n; j = j + 1) {
+            s = s + i * j;
+        }
+    }
+    s = s + a0;
+    s = s + a1;
+    s = s + a2;
+    s = s + a3;
+    s = s + a4;
+    s = s + a5;
+    s = s + a6;
+    s = s + a7;
+    s = s + a8;
+    s = s + a9;
+    s = s + a10;
+    s = s + a11;
+    s = s + a12;
+    s = s + a13;
+    s = s + a14;
+    s = s + a15;
+    printInt(s);
+}
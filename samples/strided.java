@@ -0,0 +1,14 @@
+void main() {
+    int i;
+    int j;
+    int n;
+    n = readIntFromSTDIN();
+    for (i = 0; i < 5; i = i + 1) {
+        j = i * 3;
+        printInt(j);
+    }
+    for (i = 1; i <= 3; i = i + 1) {
+        j = i * n;
+        printInt(j);
+    }
+}
@@ -0,0 +1,23 @@
+void main() {
+    int a;
+    int b;
+    int t;
+    int i;
+    int n;
+    n = readIntFromSTDIN();
+    a = 1;
+    b = 2;
+    i = 0;
+    while (i < n) {
+        t = a;
+        a = b;
+        b = t;
+        i = i + 1;
+    }
+    printInt(a);
+    printInt(b);
+    if (n > 2) {
+        a = a + 10;
+    }
+    printInt(a);
+}
@@ -0,0 +1,16 @@
+void main() {
+    int i;
+    int n;
+    int s;
+    n = readIntFromSTDIN();
+    s = 0;
+    for (i = n; i < -5; i = i + 1) {
+        s = s + 2;
+    }
+    printInt(i);
+    printInt(s);
+    for (i = 0; i < 10; i = i + 1) {
+        s = s + n;
+    }
+    printInt(s);
+}
@@ -0,0 +1,422 @@
+/* File: sccp.cc
+ * -------------
+ * Implementation of sparse conditional constant propagation.
+ */
+
+#include "sccp.h"
+#include "liveness.h"
+#include "utility.h"
+#include <algorithm>
+#include <unordered_map>
+
+enum LatticeState { Undefined, Constant, Varying };
+
+struct LatticeValue {
+    unsigned char state;        // LatticeState
+    Operand constant;           // the value when state is Constant
+
+    LatticeValue(int s = Undefined, Operand c = Operand()) : state(s), constant(c) {}
+    bool operator==(const LatticeValue &o) const
+        { return state == o.state && (state != Constant || constant == o.constant); }
+};
+
+static LatticeValue Meet(const LatticeValue &a, const LatticeValue &b) {
+    if (a.state == Undefined)
+        return b;
+    if (b.state == Undefined || a == b)
+        return a;
+    return LatticeValue(Varying);
+}
+
+static bool IsPhi(const TACObject &t) {
+    return t.type == TAC_Phi;
+}
+
+class ConstantPropagation {
+  public:
+    int usesReplaced, instructionsFolded, branchesFolded, blocksRemoved;
+    int instructionsRemoved;
+
+    ConstantPropagation(vector<TACObject> &code, AnalysisManager &analyses);
+    void Solve();
+    // Applies what Solve found to the code
+    void Rewrite();
+
+  private:
+    vector<TACObject> &code;
+    const CFG &cfg;
+    // values with a cell in every block, and which of them are globals
+    unordered_map<Operand, int, OperandHash> indices;
+    vector<int> globals;
+    vector<vector<LatticeValue> > in;   // per block
+    vector<bool> reached;
+    // values written once, before anything can read them, which is all
+    // of them in SSA form, need only one cell; when it goes down, the
+    // blocks reading them go back on the worklist
+    unordered_map<Operand, int, OperandHash> singleIndices;
+    vector<LatticeValue> single;
+    vector<vector<int> > readers;
+    vector<int> lowered;                // since the last visit
+    // which edges into each block, by predecessor index, can execute;
+    // and the value each phi argument has at the end of its edge
+    vector<vector<bool> > executable;
+    unordered_map<int, vector<LatticeValue> > phiArgValues;
+    vector<bool> phiArgsChanged;        // per block, since it was visited
+
+    typedef unordered_map<Operand, LatticeValue, OperandHash> LocalValues;
+    LatticeValue Lookup(const Operand &o, const vector<LatticeValue> &values,
+                        const LocalValues &local, const LocalValues &localGlobals) const;
+    void Visit(int b, vector<LatticeValue> &values, bool rewrite, vector<int> &succs);
+    void AddIfLiveIn(const Operand &o, int b, const unordered_map<Operand, int, OperandHash> &lastDef,
+                     unordered_map<Operand, int, OperandHash> &candidates, vector<Operand> &values);
+};
+
+ConstantPropagation::ConstantPropagation(vector<TACObject> &c, AnalysisManager &analyses)
+    : usesReplaced(0), instructionsFolded(0), branchesFolded(0), blocksRemoved(0),
+      instructionsRemoved(0),
+      code(c), cfg(analyses.GetCFG()), in(cfg.NumBlocks()), reached(cfg.NumBlocks(), false),
+      executable(cfg.NumBlocks()), phiArgsChanged(cfg.NumBlocks(), false) {
+    for (int b = 0; b < cfg.NumBlocks(); b++)
+        executable[b].assign(cfg.blocks[b].preds.size(), false);
+    for (int i = 0; i < code.size(); i++) {
+        if (code[i].type == TAC_Phi)
+            phiArgValues[i].assign(PhiArgs(code[i]).size(), LatticeValue(Undefined));
+    }
+
+    // as in Liveness: a value read before it is written in some block
+    // flows into that block from its predecessors
+    unordered_map<Operand, int, OperandHash> lastDef, candidates;
+    vector<Operand> values, exitUses;
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            Operand uses[2];
+            int numUses = UsesOf(code[i], uses);
+            for (int k = 0; k < numUses; k++)
+                AddIfLiveIn(uses[k], b, lastDef, candidates, values);
+            if (DefinesValue(code[i]))
+                lastDef[code[i].dst] = b;
+        }
+        exitUses.clear();
+        PhiUsesOnExit(code, cfg, b, exitUses);
+        for (int k = 0; k < exitUses.size(); k++)
+            AddIfLiveIn(exitUses[k], b, lastDef, candidates, values);
+    }
+
+    // the ones written once, in a block dominating all their readers, get
+    // a single cell, the others one in every block
+    vector<int> numDefs(values.size(), 0);
+    for (int i = 0; i < code.size(); i++) {
+        unordered_map<Operand, int, OperandHash>::iterator it;
+        if (DefinesValue(code[i]) && (it = candidates.find(code[i].dst)) != candidates.end())
+            numDefs[it->second]++;
+    }
+    const Dominators &dom = analyses.GetDominators();
+    for (int v = 0; v < values.size(); v++) {
+        bool dominated = numDefs[v] == 1 && !values[v].IsGlobal();
+        int def = dominated ? lastDef[values[v]] : -1;
+        for (int k = 0; k < readers[v].size() && dominated; k++)
+            dominated = readers[v][k] != def && dom.Dominates(def, readers[v][k]);
+        if (dominated) {
+            singleIndices.insert(make_pair(values[v], (int)single.size()));
+            single.push_back(LatticeValue(Undefined));
+            readers[single.size() - 1].swap(readers[v]);
+            continue;
+        }
+        if (values[v].IsGlobal())
+            globals.push_back(indices.size());
+        indices.insert(make_pair(values[v], (int)indices.size()));
+    }
+    readers.resize(single.size());
+}
+
+// Records that block b reads o before writing it, giving o a number
+void ConstantPropagation::AddIfLiveIn(const Operand &o, int b,
+                                      const unordered_map<Operand, int, OperandHash> &lastDef,
+                                      unordered_map<Operand, int, OperandHash> &candidates,
+                                      vector<Operand> &values) {
+    unordered_map<Operand, int, OperandHash>::const_iterator it = lastDef.find(o);
+    if (it != lastDef.end() && it->second == b)
+        return;
+    pair<unordered_map<Operand, int, OperandHash>::iterator, bool> added =
+        candidates.insert(make_pair(o, (int)values.size()));
+    if (added.second) {
+        values.push_back(o);
+        readers.push_back(vector<int>());
+    }
+    vector<int> &blocks = readers[added.first->second];
+    if (blocks.empty() || blocks.back() != b)
+        blocks.push_back(b);
+}
+
+LatticeValue ConstantPropagation::Lookup(const Operand &o, const vector<LatticeValue> &values,
+                                         const LocalValues &local, const LocalValues &localGlobals) const {
+    if (o.IsConstant())
+        return LatticeValue(Constant, o);
+    if (!o.IsValue())
+        return LatticeValue(Varying);
+    unordered_map<Operand, int, OperandHash>::const_iterator it = singleIndices.find(o);
+    if (it != singleIndices.end())
+        return single[it->second];
+    it = indices.find(o);
+    if (it != indices.end())
+        return values[it->second];
+    const LocalValues &m = o.IsGlobal() ? localGlobals : local;
+    LocalValues::const_iterator lt = m.find(o);
+    return lt != m.end() ? lt->second : LatticeValue(Varying);
+}
+
+// Runs block b forward from the values flowing into it, leaving the ones
+// flowing out in values and the blocks it can go on to in succs. With
+// rewrite set, it also folds the constants found into the code.
+void ConstantPropagation::Visit(int b, vector<LatticeValue> &values, bool rewrite, vector<int> &succs) {
+    static int readIntName = InternName("readIntFromSTDIN");
+    // values written earlier in this block that have no cell; a call
+    // forgets the globals, and a value with no cell and not written yet
+    // in the block can only be such a global
+    LocalValues local, localGlobals;
+
+    succs = cfg.blocks[b].succs;
+    for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+        TACObject &t = code[i];
+        LatticeValue l = Lookup(t.src1, values, local, localGlobals);
+        LatticeValue r = Lookup(t.src2, values, local, localGlobals);
+        LatticeValue result(Varying);
+        // what a binary operation comes down to, if one side is known
+        Operand simplified;
+
+        if (t.type == TAC_Assign) {
+            result = l;
+        }
+        else if (t.type == TAC_BinaryOp) {
+            Operand left = l.state == Constant ? l.constant : t.src1;
+            Operand right = r.state == Constant ? r.constant : t.src2;
+            if (SimplifyOperation(t.ops, left, right, simplified))
+                result = simplified.IsConstant() ? LatticeValue(Constant, simplified) :
+                         simplified == t.src1 ? l : r;
+            else if (l.state == Constant && r.state == Constant)
+                result = LatticeValue(Varying);
+            else if (l.state == Varying || r.state == Varying)
+                result = LatticeValue(Varying);
+            else
+                result = LatticeValue(Undefined);
+        }
+        else if (t.type == TAC_Phi) {
+            // arguments on edges not known to execute are still undefined
+            const vector<LatticeValue> &args = phiArgValues[i];
+            result = LatticeValue(Undefined);
+            for (int k = 0; k < args.size(); k++)
+                result = Meet(result, args[k]);
+        }
+        else if (t.type == TAC_IfGoto) {
+            if (l.state != Varying) {
+                // only the taken edge can execute, or none yet
+                int next = l.constant.value != 0 ? cfg.BlockForLabel(t.src2) : b + 1;
+                succs.clear();
+                if (l.state == Constant && next >= 0 && next < cfg.NumBlocks())
+                    succs.push_back(next);
+            }
+        }
+
+        if (rewrite) {
+            if (t.src1.IsValue() && l.state == Constant) {
+                t.src1 = l.constant;
+                usesReplaced++;
+            }
+            if (t.src2.IsValue() && r.state == Constant) {
+                t.src2 = r.constant;
+                usesReplaced++;
+            }
+            if (t.type == TAC_BinaryOp && result.state == Constant) {
+                t.type = TAC_Assign;
+                t.ops = OP_None;
+                t.src1 = result.constant;
+                t.src2 = Operand();
+                t.getFolded = 1;
+                instructionsFolded++;
+            }
+            else if (t.type == TAC_BinaryOp && !simplified.IsNone()) {
+                // x + 0, x * 1 and the like are copies of x
+                t.type = TAC_Assign;
+                t.ops = OP_None;
+                t.src1 = simplified;
+                t.src2 = Operand();
+                instructionsFolded++;
+            }
+            else if (t.type == TAC_Phi) {
+                // drop the arguments of edges that never execute, which
+                // the CFG of the rewritten code won't have
+                vector<Operand> &args = PhiArgs(t);
+                const vector<LatticeValue> &argValues = phiArgValues[i];
+                vector<Operand> kept;
+                for (int k = 0; k < args.size(); k++) {
+                    if (!executable[b][k])
+                        continue;
+                    if (argValues[k].state == Constant && args[k].IsValue()) {
+                        kept.push_back(argValues[k].constant);
+                        usesReplaced++;
+                    }
+                    else {
+                        kept.push_back(args[k]);
+                    }
+                }
+                args.swap(kept);
+                if (result.state == Constant || args.size() == 1) {
+                    t.type = TAC_Assign;
+                    t.src1 = result.state == Constant ? result.constant : args[0];
+                    instructionsFolded += result.state == Constant;
+                }
+            }
+            else if (t.type == TAC_IfGoto && l.state == Constant) {
+                if (l.constant.value != 0) {
+                    t.type = TAC_Goto;
+                    t.src1 = t.src2;
+                    t.src2 = Operand();
+                }
+                else {
+                    t.deadMarked = 1;
+                }
+                branchesFolded++;
+            }
+        }
+
+        if (DefinesValue(t)) {
+            if (t.type == TAC_Call || t.type == TAC_LoadParam)
+                result = LatticeValue(Varying);
+            unordered_map<Operand, int, OperandHash>::iterator it = singleIndices.find(t.dst);
+            if (it != singleIndices.end()) {
+                LatticeValue met = Meet(single[it->second], result);
+                if (!(met == single[it->second])) {
+                    single[it->second] = met;
+                    lowered.push_back(it->second);
+                }
+            }
+            else if ((it = indices.find(t.dst)) != indices.end()) {
+                values[it->second] = result;
+            }
+            else {
+                (t.dst.IsGlobal() ? localGlobals : local)[t.dst] = result;
+            }
+        }
+
+        // the callee may change any global
+        if (t.type == TAC_Call && t.src1.value != readIntName) {
+            for (int g = 0; g < globals.size(); g++)
+                values[globals[g]] = LatticeValue(Varying);
+            localGlobals.clear();
+        }
+    }
+
+    // what flows out along each edge into the phis at the other end
+    for (int k = 0; k < succs.size() && !rewrite; k++) {
+        const BasicBlock &s = cfg.blocks[succs[k]];
+        int pred = cfg.PredIndex(succs[k], b);
+        for (int i = s.begin; i < s.end; i++) {
+            if (code[i].type == TAC_Label)
+                continue;
+            if (code[i].type != TAC_Phi)
+                break;
+            LatticeValue v = Lookup(PhiArgs(code[i])[pred], values, local, localGlobals);
+            LatticeValue &arg = phiArgValues[i][pred];
+            if (!(v == arg)) {
+                arg = v;
+                phiArgsChanged[succs[k]] = true;
+            }
+        }
+    }
+}
+
+void ConstantPropagation::Solve() {
+    if (cfg.NumBlocks() == 0)
+        return;
+    // nothing is known on entry, not even for locals read before they
+    // are written
+    in[0].assign(indices.size(), LatticeValue(Varying));
+    reached[0] = true;
+    vector<int> worklist(1, 0);
+    vector<bool> onWorklist(cfg.NumBlocks(), false);
+    onWorklist[0] = true;
+
+    vector<LatticeValue> values;
+    vector<int> succs;
+    while (!worklist.empty()) {
+        int b = worklist.back();
+        worklist.pop_back();
+        onWorklist[b] = false;
+
+        values = in[b];
+        Visit(b, values, false, succs);
+        for (int k = 0; k < lowered.size(); k++) {
+            const vector<int> &blocks = readers[lowered[k]];
+            for (int r = 0; r < blocks.size(); r++) {
+                if (reached[blocks[r]] && !onWorklist[blocks[r]]) {
+                    worklist.push_back(blocks[r]);
+                    onWorklist[blocks[r]] = true;
+                }
+            }
+        }
+        lowered.clear();
+        for (int k = 0; k < succs.size(); k++) {
+            int s = succs[k];
+            int pred = cfg.PredIndex(s, b);
+            bool changed = !reached[s] || !executable[s][pred] || phiArgsChanged[s];
+            executable[s][pred] = true;
+            phiArgsChanged[s] = false;
+            if (!reached[s]) {
+                reached[s] = true;
+                in[s] = values;
+            }
+            for (int v = 0; v < values.size(); v++) {
+                LatticeValue met = Meet(in[s][v], values[v]);
+                if (!(met == in[s][v])) {
+                    in[s][v] = met;
+                    changed = true;
+                }
+            }
+            if (changed && !onWorklist[s]) {
+                worklist.push_back(s);
+                onWorklist[s] = true;
+            }
+        }
+    }
+}
+
+void ConstantPropagation::Rewrite() {
+    vector<LatticeValue> values;
+    vector<int> succs;
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        if (reached[b]) {
+            // phis that become copies move below the ones left
+            int phis = cfg.blocks[b].begin, endOfPhis = phis;
+            if (phis < cfg.blocks[b].end && code[phis].type == TAC_Label)
+                endOfPhis = ++phis;
+            while (endOfPhis < cfg.blocks[b].end && code[endOfPhis].type == TAC_Phi)
+                endOfPhis++;
+            values = in[b];
+            Visit(b, values, true, succs);
+            stable_partition(code.begin() + phis, code.begin() + endOfPhis, IsPhi);
+            continue;
+        }
+        // nothing can jump to the label of a block that is never
+        // reached, so it goes too
+        blocksRemoved++;
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            int type = code[i].type;
+            if (type != TAC_FuncLabel && type != TAC_BeginFunc && type != TAC_EndFunc)
+                code[i].deadMarked = 1;
+        }
+    }
+
+    instructionsRemoved = RemoveDeadMarked(code);
+}
+
+bool constantPropagation(vector<TACObject> &tac, AnalysisManager &analyses)
+{
+    ConstantPropagation sccp(tac, analyses);
+    sccp.Solve();
+    sccp.Rewrite();
+    PrintDebug("sccp", "%d uses replaced, %d operations and %d branches folded, "
+               "%d blocks unreachable", sccp.usesReplaced, sccp.instructionsFolded,
+               sccp.branchesFolded, sccp.blocksRemoved);
+    return sccp.usesReplaced > 0 || sccp.instructionsFolded > 0 ||
+           sccp.branchesFolded > 0 || sccp.instructionsRemoved > 0;
+}
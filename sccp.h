@@ -0,0 +1,39 @@
+/* File: sccp.h
+ * ------------
+ * Sparse conditional constant propagation over one function's TAC.
+ *
+ * Every value starts out undefined and is lowered to a constant, then to
+ * varying, as definitions of it are found on paths that can execute. A
+ * block is only visited once some edge into it is known to execute, and
+ * a conditional jump whose condition is a constant only makes its taken
+ * edge executable, so constants flow through code that is dead only
+ * because of them, and around loops whose body keeps a value unchanged.
+ *
+ * Blocks are revisited off a worklist only when the values flowing into
+ * them go down, and, as in the liveness analysis, only the values read
+ * in a block before being written there get a per-block lattice cell.
+ */
+
+#ifndef _H_sccp
+#define _H_sccp
+
+#include "tac.h"
+#include "analyses.h"
+#include <vector>
+using namespace std;
+
+/* Function: constantPropagation
+ * -----------------------------
+ * Replaces every read of a value known to be constant by that constant,
+ * turns operations on constants, and ones a constant side decides, such
+ * as x + 0 or x * 0, into copies, turns conditional jumps on constants
+ * into gotos or drops them, and deletes blocks that can never be reached,
+ * except for the function markers. In SSA form a phi argument
+ * only counts once its edge is known to execute, and the arguments of
+ * edges that never do are dropped. Works in place and returns whether
+ * anything changed. The "sccp" debug key prints how much of each of
+ * these it did.
+ */
+bool constantPropagation(vector<TACObject> &tac, AnalysisManager &analyses);
+
+#endif
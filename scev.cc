@@ -0,0 +1,381 @@
+/* File: scev.cc
+ * -------------
+ * Implementation of the closed-form evaluation of counted loops.
+ */
+
+#include "scev.h"
+#include "utility.h"
+#include <limits.h>
+#include <unordered_set>
+
+// A value of a loop as a function of the trip m it is read in: the sum
+// of coefficient k times C(m, k), every coefficient the same all through
+// the loop, so {a, b} is a + b*m and {a, b, c} adds c*m*(m-1)/2
+typedef vector<Operand> Recurrence;
+
+// How deep Read follows a value back through the code
+static const int maxDepth = 32;
+
+class ClosedForms {
+  public:
+    int evaluated, values;
+
+    ClosedForms(TACFunction *fn, AnalysisManager &analyses);
+    // Does loop l, which must not be done before the loops inside it
+    void Evaluate(int l);
+    // Puts the code computing the closed forms into the preheaders
+    void Apply() { InsertAll(code, inserts); }
+
+  private:
+    TACFunction *fn;
+    vector<TACObject> &code;
+    const CFG &cfg;
+    const LoopInfo &loops;
+    DefUse &chains;
+    Insertions inserts;
+    // the loop being evaluated, the code for its preheader so far and the
+    // phis of its header read already, or being read
+    int loop;
+    vector<TACObject> pending;
+    unordered_map<Operand, Recurrence, OperandHash> solved;
+    unordered_set<Operand, OperandHash> solving;
+
+    bool IsPure(int l);
+    bool IsInvariant(const Operand &o);
+    Operand Resolve(const Operand &o);
+    Operand Emit(int op, const Operand &a, const Operand &b);
+    Recurrence Combine(int op, const Recurrence &a, const Recurrence &b);
+    bool Read(const Operand &v, const Operand &self, int depth, long long &selves, Recurrence &r);
+    bool Solve(const Operand &phi, Recurrence &r);
+    Operand TripCount(const Recurrence &x, int op, const Operand &bound, bool &ends, bool &small);
+    Operand Pairs(const Operand &trips, bool small);
+    Operand ValueAt(const Recurrence &r, const Operand &trips, bool small, Operand &pairs);
+};
+
+ClosedForms::ClosedForms(TACFunction *fn, AnalysisManager &analyses)
+    : evaluated(0), values(0), fn(fn), code(fn->code), cfg(analyses.GetCFG()),
+      loops(analyses.GetLoops()), chains(analyses.GetDefUse()), loop(-1) {}
+
+// Whether loop l does nothing but compute values of its own: skipping
+// its trips is then only seen through the values it leaves, which are
+// those of its header, as that is where it leaves from
+bool ClosedForms::IsPure(int l) {
+    const vector<int> &blocks = loops.loops[l].blocks;
+    int header = loops.loops[l].header;
+    for (int k = 0; k < blocks.size(); k++) {
+        // a loop inside may never end
+        if (loops.LoopOf(blocks[k]) != l)
+            return false;
+        for (int i = cfg.blocks[blocks[k]].begin; i < cfg.blocks[blocks[k]].end; i++) {
+            const TACObject &t = code[i];
+            if (t.type == TAC_Label || t.type == TAC_Phi || t.type == TAC_Goto || t.type == TAC_IfGoto ||
+                t.type == TAC_Nop)
+                continue;
+            if ((t.type != TAC_Assign && t.type != TAC_BinaryOp) || t.dst.IsGlobal() ||
+                chains.NumDefs(t.dst) != 1)
+                return false;
+            for (int u = 0; u < chains.NumUses(t.dst) && blocks[k] != header; u++) {
+                if (!loops.Contains(l, cfg.blockOf[chains.UseAt(t.dst, u).instr]))
+                    return false;
+            }
+            if (t.type == TAC_BinaryOp && t.ops == OP_Div && (t.src2.kind != OPND_Int || t.src2.value == 0))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Whether o holds the same value all through the loop; a global does, as
+// the loop neither stores to it nor calls anything
+bool ClosedForms::IsInvariant(const Operand &o) {
+    return o.IsGlobal() || ::IsInvariant(loops, cfg.blockOf, chains, loop, o);
+}
+
+// The constant o is a copy of, through other copies, or else o
+Operand ClosedForms::Resolve(const Operand &o) {
+    Operand v = o;
+    for (int k = 0; k < maxDepth && v.IsValue() && !v.IsGlobal() && chains.NumDefs(v) == 1; k++) {
+        const TACObject &t = code[chains.DefAt(v, 0)];
+        if (t.type != TAC_Assign)
+            break;
+        v = t.src1;
+    }
+    return v.IsConstant() ? v : o;
+}
+
+// A value holding a op b, computed at the end of the preheader unless it
+// folds
+Operand ClosedForms::Emit(int op, const Operand &a, const Operand &b) {
+    Operand result;
+    if (a.IsConstant() && b.IsConstant() && FoldOperation(op, a, b, result))
+        return result;
+    bool zeroA = a.kind == OPND_Int && a.value == 0, zeroB = b.kind == OPND_Int && b.value == 0;
+    bool oneA = a.kind == OPND_Int && a.value == 1, oneB = b.kind == OPND_Int && b.value == 1;
+    if ((op == OP_Add && zeroB) || (op == OP_Sub && zeroB) || (op == OP_Mul && oneB) || (op == OP_Div && oneB))
+        return a;
+    if ((op == OP_Add && zeroA) || (op == OP_Mul && oneA))
+        return b;
+    if (op == OP_Mul && (zeroA || zeroB))
+        return Operand::Int(0);
+    for (int k = 0; k < pending.size(); k++) {
+        if (pending[k].ops == op && pending[k].src1 == a && pending[k].src2 == b)
+            return pending[k].dst;
+    }
+    result = fn->NewVariable("scev");
+    pending.push_back(NewOperation(op, result, a, b));
+    return result;
+}
+
+// a plus or minus b, coefficient by coefficient
+Recurrence ClosedForms::Combine(int op, const Recurrence &a, const Recurrence &b) {
+    Recurrence r(max(a.size(), b.size()));
+    for (int k = 0; k < r.size(); k++)
+        r[k] = Emit(op, k < a.size() ? a[k] : Operand::Int(0), k < b.size() ? b[k] : Operand::Int(0));
+    return r;
+}
+
+// Reads v as selves times self, a phi of the header, plus r, returning
+// whether it could
+bool ClosedForms::Read(const Operand &v, const Operand &self, int depth, long long &selves, Recurrence &r) {
+    selves = 0;
+    if (depth > maxDepth)
+        return false;
+    if (IsInvariant(v)) {
+        r.assign(1, Resolve(v));
+        return true;
+    }
+    if (!v.IsValue() || chains.NumDefs(v) != 1)
+        return false;
+    int d = chains.DefAt(v, 0);
+    const TACObject &t = code[d];
+    if (t.type == TAC_Phi) {
+        if (cfg.blockOf[d] != loops.loops[loop].header)
+            return false;
+        if (v != self)
+            return Solve(v, r);
+        selves = 1;
+        r.assign(1, Operand::Int(0));
+        return true;
+    }
+    if (t.type == TAC_Assign)
+        return Read(t.src1, self, depth + 1, selves, r);
+    if (t.type != TAC_BinaryOp || (t.ops != OP_Add && t.ops != OP_Sub && t.ops != OP_Mul))
+        return false;
+
+    long long leftSelves, rightSelves;
+    Recurrence left, right;
+    if (!Read(t.src1, self, depth + 1, leftSelves, left) || !Read(t.src2, self, depth + 1, rightSelves, right))
+        return false;
+    if (t.ops != OP_Mul) {
+        selves = t.ops == OP_Add ? leftSelves + rightSelves : leftSelves - rightSelves;
+        r = Combine(t.ops, left, right);
+        return selves >= INT_MIN && selves <= INT_MAX;
+    }
+    // a product is one only when a side is the same all through the loop,
+    // and a constant if the other side counts in self
+    if (rightSelves != 0 || right.size() != 1 || (leftSelves != 0 && right[0].kind != OPND_Int)) {
+        swap(left, right);
+        swap(leftSelves, rightSelves);
+    }
+    if (rightSelves != 0 || right.size() != 1 || (leftSelves != 0 && right[0].kind != OPND_Int))
+        return false;
+    selves = leftSelves * (leftSelves != 0 ? right[0].value : 0);
+    r.resize(left.size());
+    for (int k = 0; k < left.size(); k++)
+        r[k] = Emit(OP_Mul, left[k], right[0]);
+    return selves >= INT_MIN && selves <= INT_MAX;
+}
+
+// Reads the phi of the header as a function of the trip, returning
+// whether it is one: it must go up each trip by a function of degree 1
+// at most, the same around every back edge
+bool ClosedForms::Solve(const Operand &phi, Recurrence &r) {
+    unordered_map<Operand, Recurrence, OperandHash>::const_iterator found = solved.find(phi);
+    if (found != solved.end()) {
+        r = found->second;
+        return true;
+    }
+    if (solving.count(phi) > 0)
+        return false;
+    const vector<Operand> &args = PhiArgs(code[chains.DefAt(phi, 0)]);
+    const vector<int> &preds = cfg.blocks[loops.loops[loop].header].preds;
+    Operand init, next;
+    for (int k = 0; k < preds.size(); k++) {
+        if (!loops.Contains(loop, preds[k]))
+            init = args[k];
+        else if (next.IsNone())
+            next = args[k];
+        else if (args[k] != next)
+            return false;
+    }
+
+    solving.insert(phi);
+    long long selves;
+    Recurrence step;
+    bool ok = !next.IsNone() && Read(next, phi, 0, selves, step) && selves == 1 && step.size() <= 2;
+    solving.erase(phi);
+    if (!ok)
+        return false;
+    r.assign(1, Resolve(init));
+    r.insert(r.end(), step.begin(), step.end());
+    solved[phi] = r;
+    return true;
+}
+
+// The trips a loop makes that goes on while x op bound, or none if that
+// can't be worked out; ends tells whether the loop is sure to end after
+// them, and small whether they are sure to be at most INT_MAX
+Operand ClosedForms::TripCount(const Recurrence &x, int op, const Operand &bound, bool &ends, bool &small) {
+    if (x[1].kind != OPND_Int || x[1].value == 0)
+        return Operand();
+    int step = x[1].value;
+    if (x[0].kind == OPND_Int && bound.kind == OPND_Int) {
+        long long trips = CountTrips(op, x[0].value, step, bound.value);
+        if (trips < 0 || trips > INT_MAX)
+            return Operand();
+        ends = small = true;
+        return Operand::Int(trips);
+    }
+    if (step != 1 && step != -1)
+        return Operand();
+
+    // the distance to the bound wraps around to the trips exactly, read
+    // as unsigned; a test of != may take all the way round
+    bool up = step == 1;
+    if (op == OP_Ne) {
+        ends = true;
+        small = false;
+        return up ? Emit(OP_Sub, bound, x[0]) : Emit(OP_Sub, x[0], bound);
+    }
+    bool inclusive = op == (up ? OP_Le : OP_Ge);
+    if (op != (up ? OP_Lt : OP_Gt) && !inclusive)
+        return Operand();
+    // an inclusive bound is one trip further, counted from one step back
+    Operand from = x[0];
+    if (inclusive)
+        from = Emit(OP_Sub, x[0], x[1]);
+    Operand distance = up ? Emit(OP_Sub, bound, from) : Emit(OP_Sub, from, bound);
+    // or none if the test fails on the way in; a comparison is 0 or 1
+    Operand trips = Emit(OP_Mul, Emit(op, x[0], bound), distance);
+    // i <= n never ends for n the largest int
+    ends = !inclusive;
+    small = x[0].kind == OPND_Int && (up ? x[0].value >= (int)inclusive : x[0].value <= -1 - (int)inclusive);
+    return trips;
+}
+
+// trips*(trips-1)/2, the number of pairs of trips: with trips = 2h + r
+// for r 0 or 1 it is h*(trips + r - 1), and no product overflows before
+// the halving
+Operand ClosedForms::Pairs(const Operand &trips, bool small) {
+    Operand half;
+    if (small) {
+        half = Emit(OP_Div, trips, Operand::Int(2));
+    }
+    else {
+        // past INT_MAX the count reads as negative, and dividing it would
+        // round the wrong way, so halve it less 2^31 and add 2^30 back
+        Operand high = Emit(OP_Lt, trips, Operand::Int(0));
+        Operand low = Emit(OP_Sub, trips, Emit(OP_Mul, high, Operand::Int(INT_MIN)));
+        half = Emit(OP_Add, Emit(OP_Div, low, Operand::Int(2)), Emit(OP_Mul, high, Operand::Int(1 << 30)));
+    }
+    Operand odd = Emit(OP_Sub, trips, Emit(OP_Add, half, half));
+    return Emit(OP_Mul, half, Emit(OP_Sub, Emit(OP_Add, trips, odd), Operand::Int(1)));
+}
+
+// The value of r after the given trips, with the pairs of trips worked
+// out the first time they are needed
+Operand ClosedForms::ValueAt(const Recurrence &r, const Operand &trips, bool small, Operand &pairs) {
+    Operand value = r[0];
+    if (r.size() > 1)
+        value = Emit(OP_Add, value, Emit(OP_Mul, r[1], trips));
+    if (r.size() > 2) {
+        if (pairs.IsNone())
+            pairs = Pairs(trips, small);
+        value = Emit(OP_Add, value, Emit(OP_Mul, r[2], pairs));
+    }
+    return value;
+}
+
+void ClosedForms::Evaluate(int l) {
+    const Loop &lp = loops.loops[l];
+    int preheader = loops.Preheader(cfg, l);
+    if (preheader < 0 || !IsPure(l))
+        return;
+    const BasicBlock &header = cfg.blocks[lp.header];
+    const TACObject &jump = code[header.end - 1];
+    if (jump.type != TAC_IfGoto || !jump.src1.IsValue() || jump.src1.IsGlobal() ||
+        chains.NumDefs(jump.src1) != 1)
+        return;
+    int test = chains.DefAt(jump.src1, 0);
+    if (cfg.blockOf[test] != lp.header || code[test].type != TAC_BinaryOp || !IsComparison(code[test].ops))
+        return;
+    // the header alone leaves the loop, so the test counts the trips
+    int taken = cfg.BlockForLabel(jump.src2);
+    if (header.succs.size() != 2 || taken < 0)
+        return;
+    bool stays = loops.Contains(l, taken);
+    int other = header.succs[0] == taken ? header.succs[1] : header.succs[0];
+    if (loops.Contains(l, other) == stays)
+        return;
+    for (int k = 0; k < lp.blocks.size(); k++) {
+        const vector<int> &succs = cfg.blocks[lp.blocks[k]].succs;
+        for (int s = 0; s < succs.size() && lp.blocks[k] != lp.header; s++) {
+            if (!loops.Contains(l, succs[s]))
+                return;
+        }
+    }
+
+    loop = l;
+    pending.clear();
+    solved.clear();
+    vector<int> phis;
+    for (int i = header.begin; i < header.end; i++) {
+        Recurrence r;
+        if (code[i].type != TAC_Phi)
+            continue;
+        if (!Solve(code[i].dst, r))
+            return;
+        phis.push_back(i);
+    }
+    long long leftSelves, rightSelves;
+    Recurrence left, right;
+    if (!Read(code[test].src1, Operand(), 0, leftSelves, left) ||
+        !Read(code[test].src2, Operand(), 0, rightSelves, right))
+        return;
+    int op = code[test].ops;
+    bool ends, small;
+    Operand trips;
+    if (left.size() == 2 && right.size() == 1)
+        trips = TripCount(left, stays ? op : NegatedComparison(op), right[0], ends, small);
+    else if (right.size() == 2 && left.size() == 1)
+        trips = TripCount(right, MirroredComparison(stays ? op : NegatedComparison(op)), left[0], ends, small);
+    if (trips.IsNone())
+        return;
+
+    // the phis start where the loop would leave them
+    Operand pairs;
+    for (int k = 0; k < phis.size(); k++) {
+        TACObject phi = NewPhi(code[phis[k]].dst, header.preds.size(), Operand());
+        PhiArgs(phi) = PhiArgs(code[phis[k]]);
+        PhiArgs(phi)[cfg.PredIndex(lp.header, preheader)] = ValueAt(solved[phi.dst], trips, small, pairs);
+        chains.Replace(phis[k], phi);
+    }
+    Operand last = ends ? Operand::Bool(!stays)
+                        : Emit(op, ValueAt(left, trips, small, pairs), ValueAt(right, trips, small, pairs));
+    chains.Replace(test, NewCopy(code[test].dst, last));
+    inserts.push_back(make_pair(EndOf(code, cfg.blocks[preheader]), pending));
+    evaluated++;
+    values += phis.size();
+}
+
+bool EvaluateCountedLoops(TACFunction *fn, AnalysisManager &analyses) {
+    if (fn->code.empty() || !fn->inSSA || analyses.GetLoops().loops.empty())
+        return false;
+    ClosedForms forms(fn, analyses);
+    for (int l = 0; l < analyses.GetLoops().loops.size(); l++)
+        forms.Evaluate(l);
+    forms.Apply();
+    PrintDebug("scev", "%s: %d loops evaluated, %d values in closed form",
+               NameOf(fn->name.value).c_str(), forms.evaluated, forms.values);
+    return forms.evaluated > 0;
+}
@@ -0,0 +1,59 @@
+/* File: scev.h
+ * ------------
+ * Closed-form evaluation of counted loops over one function's TAC in SSA
+ * form.
+ *
+ * The values of a loop are read as functions of the trip they are read
+ * in, numbered from 0: a value that is the same all through the loop is
+ * a constant function, and a phi of the header that starts at a and
+ * goes up each trip by such a function of degree d is one of degree
+ * d + 1, such as i.2 and sum.2 in
+ *
+ *     i.2 := phi(1, i.3)                  1 + m
+ *     sum.2 := phi(0, sum.3)              0 + m + m*(m-1)/2
+ *     t2 := i.2 <= n
+ *     if t2 goto L1
+ *     ...
+ *     t3 := sum.2 + i.2
+ *     sum.3 := t3
+ *     t4 := i.2 + 1
+ *     i.3 := t4
+ *
+ * Sums, differences and products by invariants of these stay such
+ * functions; anything else, and degrees past 2, are not evaluated.
+ *
+ * A loop that only its header leaves, on a test of a function of degree
+ * 1 going up or down by 1 against an invariant bound, makes a number of
+ * trips that can be computed before it runs. If it has no calls, no
+ * prints, no stores to globals, no divisions that may trap and no loops
+ * inside, writes no variable it doesn't define alone and every phi of
+ * its header is such a function, the preheader works out the trip count
+ * and the value of each phi after that many trips, and the phis start
+ * from those instead: the loop finds its test failing right away and
+ * leaves with the values it would have had. The test is then a constant
+ * if the loop is known to end, and sccp takes the body away, or else the
+ * same test of the final values worked out in the preheader, so that a
+ * loop that never ends, such as i <= n for n the largest int, still
+ * doesn't. With a constant start and bound the step may be any constant.
+ *
+ * Everything wraps around on overflow the same way the loop would, so
+ * the values are exact; the halving in m*(m-1)/2 is done on whichever
+ * of m and m - 1 is even.
+ */
+
+#ifndef _H_scev
+#define _H_scev
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: EvaluateCountedLoops
+ * ------------------------------
+ * Replaces the loops that allow it with their closed forms, in place,
+ * returning whether anything changed. Does nothing to a function not in
+ * SSA form. The "scev" debug key prints, for each function, the loops
+ * evaluated and the values given closed forms.
+ */
+bool EvaluateCountedLoops(TACFunction *fn, AnalysisManager &analyses);
+
+#endif
@@ -0,0 +1,453 @@
+/* File: ssa.cc
+ * ------------
+ * Implementation of SSA construction and destruction.
+ */
+
+#include "ssa.h"
+#include "cfg.h"
+#include "dominators.h"
+#include "liveness.h"
+#include "utility.h"
+#include <algorithm>
+#include <unordered_map>
+
+// Where the phis of a block go: right after its label, if it has one
+static int AfterLabel(const vector<TACObject> &code, const BasicBlock &block) {
+    if (block.begin < block.end && code[block.begin].type == TAC_Label)
+        return block.begin + 1;
+    return block.begin;
+}
+
+Operand NewVersion(TACFunction *fn, const Operand &var) {
+    string name = NameOf(var.value) + "." + to_string(++fn->lastVersion[var.value]);
+    Operand version = Operand::Var(InternName(name), fn->NewSlot());
+    fn->ssaVersions[version.slot] = var;
+    return version;
+}
+
+bool BuildSSA(TACFunction *fn, AnalysisManager &analyses) {
+    if (fn->IsTopLevel() || fn->inSSA)
+        return false;
+    vector<TACObject> &code = fn->code;
+    const CFG &cfg = analyses.GetCFG();
+    const Dominators &dom = analyses.GetDominators();
+    int n = cfg.NumBlocks();
+
+    // the locals written more than once, by slot since variables in
+    // different scopes may share a name, and the blocks writing them
+    vector<Operand> vars;
+    unordered_map<int, int> varOfSlot;
+    vector<int> numDefs;
+    vector<vector<int> > defBlocks;
+    for (int b = 0; b < n; b++) {
+        for (int i = cfg.blocks[b].begin; i < cfg.blocks[b].end; i++) {
+            const TACObject &t = code[i];
+            if (!DefinesValue(t) || t.dst.kind != OPND_Var)
+                continue;
+            unordered_map<int, int>::iterator it = varOfSlot.find(t.dst.slot);
+            if (it == varOfSlot.end()) {
+                it = varOfSlot.insert(make_pair((int)t.dst.slot, (int)vars.size())).first;
+                vars.push_back(t.dst);
+                numDefs.push_back(0);
+                defBlocks.push_back(vector<int>());
+            }
+            int v = it->second;
+            numDefs[v]++;
+            if (defBlocks[v].empty() || defBlocks[v].back() != b)
+                defBlocks[v].push_back(b);
+        }
+    }
+    for (unordered_map<int, int>::iterator it = varOfSlot.begin(); it != varOfSlot.end(); ) {
+        if (numDefs[it->second] < 2)
+            it = varOfSlot.erase(it);
+        else
+            ++it;
+    }
+
+    // a phi goes wherever two definitions meet, but only if the variable
+    // is still live there
+    const Liveness &liveness = analyses.GetLiveness();
+    vector<vector<int> > frontiers = dom.Frontiers(cfg);
+    vector<vector<int> > phisAt(n);
+    vector<int> hasPhi(n, -1), queued(n, -1);
+    int numRenamed = 0, numPhis = 0;
+    for (int v = 0; v < vars.size(); v++) {
+        if (numDefs[v] < 2)
+            continue;
+        numRenamed++;
+        int live = liveness.IndexOf(vars[v]);
+        if (live < 0)
+            continue;
+        vector<int> worklist = defBlocks[v];
+        for (int k = 0; k < worklist.size(); k++)
+            queued[worklist[k]] = v;
+        while (!worklist.empty()) {
+            int b = worklist.back();
+            worklist.pop_back();
+            for (int k = 0; k < frontiers[b].size(); k++) {
+                int d = frontiers[b][k];
+                if (hasPhi[d] == v || !liveness.IsLiveIn(d, live))
+                    continue;
+                hasPhi[d] = v;
+                phisAt[d].push_back(v);
+                numPhis++;
+                if (queued[d] != v) {
+                    queued[d] = v;
+                    worklist.push_back(d);
+                }
+            }
+        }
+    }
+
+    Insertions inserts;
+    unordered_map<int, int> varOfPhi;   // by argument list
+    for (int b = 0; b < n; b++) {
+        if (phisAt[b].empty())
+            continue;
+        vector<TACObject> phis;
+        for (int k = 0; k < phisAt[b].size(); k++) {
+            int v = phisAt[b][k];
+            phis.push_back(NewPhi(vars[v], cfg.blocks[b].preds.size(), vars[v]));
+            varOfPhi[phis.back().src1.value] = v;
+        }
+        inserts.push_back(make_pair(AfterLabel(code, cfg.blocks[b]), phis));
+    }
+    InsertAll(code, inserts);
+    // the same blocks, only longer, so the dominators still hold
+    if (numPhis > 0)
+        analyses.Invalidate(ANALYSIS_Dominators | ANALYSIS_Loops);
+    const CFG &withPhis = analyses.GetCFG();
+
+    // rename down the dominator tree, each definition pushing a new
+    // version that the blocks it dominates read until it is popped again
+    // on the way back up; a negative entry on the stack is a block to
+    // leave
+    vector<vector<Operand> > current(vars.size());
+    vector<vector<int> > pushed(n);
+    vector<int> stack(n > 0 ? 1 : 0, 0);
+    while (!stack.empty()) {
+        int b = stack.back();
+        stack.pop_back();
+        if (b < 0) {
+            for (int k = 0; k < pushed[~b].size(); k++)
+                current[pushed[~b][k]].pop_back();
+            continue;
+        }
+        stack.push_back(~b);
+
+        for (int i = withPhis.blocks[b].begin; i < withPhis.blocks[b].end; i++) {
+            TACObject &t = code[i];
+            Operand *srcs[] = { &t.src1, &t.src2 };
+            for (int k = 0; k < 2; k++) {
+                if (srcs[k]->kind != OPND_Var)
+                    continue;
+                unordered_map<int, int>::iterator it = varOfSlot.find(srcs[k]->slot);
+                if (it != varOfSlot.end() && !current[it->second].empty())
+                    *srcs[k] = current[it->second].back();
+            }
+            if (!DefinesValue(t) || t.dst.kind != OPND_Var)
+                continue;
+            unordered_map<int, int>::iterator it = varOfSlot.find(t.dst.slot);
+            if (it == varOfSlot.end())
+                continue;
+            t.dst = NewVersion(fn, vars[it->second]);
+            current[it->second].push_back(t.dst);
+            pushed[b].push_back(it->second);
+        }
+
+        const vector<int> &succs = withPhis.blocks[b].succs;
+        for (int k = 0; k < succs.size(); k++) {
+            const BasicBlock &s = withPhis.blocks[succs[k]];
+            int pred = withPhis.PredIndex(succs[k], b);
+            for (int i = AfterLabel(code, s); i < s.end && code[i].type == TAC_Phi; i++) {
+                int v = varOfPhi[code[i].src1.value];
+                if (!current[v].empty())
+                    PhiArgs(code[i])[pred] = current[v].back();
+            }
+        }
+        for (int k = dom.children[b].size() - 1; k >= 0; k--)
+            stack.push_back(dom.children[b][k]);
+    }
+
+    fn->inSSA = true;
+    PrintDebug("ssa", "%s: %d variables renamed, %d phis placed",
+               NameOf(fn->name.value).c_str(), numRenamed, numPhis);
+    return numRenamed > 0;
+}
+
+// The copies that pass the arguments of predecessor k to the phis in
+// [first, end), ordered so no copy overwrites a value a later one reads
+static vector<TACObject> SequentialCopies(const vector<TACObject> &code, int first, int end,
+                                          int k, TACFunction *fn, int &swaps) {
+    vector<Operand> dsts, srcs;
+    for (int i = first; i < end; i++) {
+        const Operand &arg = PhiArgs(code[i])[k];
+        if (arg != code[i].dst) {
+            dsts.push_back(code[i].dst);
+            srcs.push_back(arg);
+        }
+    }
+
+    vector<TACObject> copies;
+    while (!dsts.empty()) {
+        int ready = -1;
+        for (int c = 0; c < dsts.size() && ready < 0; c++) {
+            ready = c;
+            for (int o = 0; o < srcs.size(); o++) {
+                if (o != c && srcs[o] == dsts[c])
+                    ready = -1;
+            }
+        }
+        if (ready < 0) {
+            // what is left are cycles: move one destination out of the way
+            string name = "swap." + to_string(++swaps);
+            Operand swap = Operand::Var(InternName(name), fn->NewSlot());
+            copies.push_back(NewCopy(swap, dsts[0]));
+            for (int o = 0; o < srcs.size(); o++) {
+                if (srcs[o] == dsts[0])
+                    srcs[o] = swap;
+            }
+            continue;
+        }
+        copies.push_back(NewCopy(dsts[ready], srcs[ready]));
+        dsts.erase(dsts.begin() + ready);
+        srcs.erase(srcs.begin() + ready);
+    }
+    return copies;
+}
+
+// The local whose version o is, or o itself if o is such a local; the
+// none operand for anything else
+static Operand LocalOf(const Operand &o, const vector<Operand> &localOf) {
+    return o.kind == OPND_Var ? localOf[o.slot] : Operand();
+}
+
+// Tracks which versions of the renamed locals are live during a backward
+// walk over a block, and how many of each local, by frame slot
+struct LiveVersions {
+    vector<bool> isLive;
+    vector<int> count;
+    vector<pair<int, int> > added;      // (version, local) since Clear
+
+    LiveVersions(int numSlots) : isLive(numSlots, false), count(numSlots, 0) {}
+
+    void Add(const Operand &o, const Operand &local) {
+        if (!local.IsNone() && !isLive[o.slot]) {
+            isLive[o.slot] = true;
+            count[local.slot]++;
+            added.push_back(make_pair((int)o.slot, (int)local.slot));
+        }
+    }
+    void Remove(const Operand &o, const Operand &local) {
+        if (!local.IsNone() && isLive[o.slot]) {
+            isLive[o.slot] = false;
+            count[local.slot]--;
+        }
+    }
+    bool Has(const Operand &o) const { return o.kind == OPND_Var && isLive[o.slot]; }
+    // live versions of the local other than a and b
+    int Others(const Operand &local, const Operand &a, const Operand &b) const {
+        return count[local.slot] - Has(a) - (a.slot != b.slot && Has(b));
+    }
+    void Clear() {
+        for (int k = 0; k < added.size(); k++) {
+            isLive[added[k].first] = false;
+            count[added[k].second] = 0;
+        }
+        added.clear();
+    }
+};
+
+// Gives the versions of each local its own slot and name back, unless two
+// of them are live at once, which the passes can bring about by moving
+// code. A version is written while another is live only by a copy of it,
+// from a phi or not; then both hold the same value anyway. Returns the
+// number of locals merged back.
+static int CoalesceVersions(TACFunction *fn) {
+    vector<TACObject> &code = fn->code;
+    // the local each version renames, and each local itself, by slot
+    vector<Operand> localOf(fn->numSlots);
+    int numLocals = 0;
+    for (unordered_map<int, Operand>::iterator it = fn->ssaVersions.begin();
+         it != fn->ssaVersions.end(); ++it) {
+        localOf[it->first] = it->second;
+        if (localOf[it->second.slot].IsNone())
+            numLocals++;
+        localOf[it->second.slot] = it->second;
+    }
+    if (numLocals == 0)
+        return 0;
+
+    CFG cfg(code);
+    Liveness liveness(code, cfg);
+    vector<bool> interferes(fn->numSlots, false);
+    int numInterfering = 0;
+    LiveVersions live(fn->numSlots);
+    vector<Operand> exitUses;
+    for (int b = 0; b < cfg.NumBlocks(); b++) {
+        live.Clear();
+        const vector<int> &out = liveness.liveOut[b];
+        for (int k = 0; k < out.size(); k++)
+            live.Add(liveness.ValueAt(out[k]), LocalOf(liveness.ValueAt(out[k]), localOf));
+        exitUses.clear();
+        PhiUsesOnExit(code, cfg, b, exitUses);
+        for (int k = 0; k < exitUses.size(); k++)
+            live.Add(exitUses[k], LocalOf(exitUses[k], localOf));
+
+        // the copies for the phis of the successors go at the very end
+        vector<int> clashes;
+        const vector<int> &succs = cfg.blocks[b].succs;
+        for (int k = 0; k < succs.size(); k++) {
+            const BasicBlock &s = cfg.blocks[succs[k]];
+            int pred = cfg.PredIndex(succs[k], b);
+            for (int i = AfterLabel(code, s); i < s.end && code[i].type == TAC_Phi; i++) {
+                Operand local = LocalOf(code[i].dst, localOf);
+                const Operand &arg = PhiArgs(code[i])[pred];
+                Operand from = LocalOf(arg, localOf) == local ? arg : code[i].dst;
+                if (live.Others(local, from, code[i].dst) > 0)
+                    clashes.push_back(local.slot);
+            }
+        }
+
+        for (int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].begin; i--) {
+            const TACObject &t = code[i];
+            if (DefinesValue(t)) {
+                Operand local = LocalOf(t.dst, localOf);
+                live.Remove(t.dst, local);
+                bool isCopy = t.type == TAC_Assign && LocalOf(t.src1, localOf) == local;
+                if (!local.IsNone() && live.Others(local, isCopy ? t.src1 : t.dst, t.dst) > 0)
+                    clashes.push_back(local.slot);
+            }
+            Operand uses[2];
+            for (int k = UsesOf(t, uses) - 1; k >= 0; k--)
+                live.Add(uses[k], LocalOf(uses[k], localOf));
+        }
+
+        for (int k = 0; k < clashes.size(); k++) {
+            if (!interferes[clashes[k]]) {
+                interferes[clashes[k]] = true;
+                numInterfering++;
+            }
+        }
+    }
+
+    for (int i = 0; i < code.size(); i++) {
+        Operand *opnds[] = { &code[i].dst, &code[i].src1, &code[i].src2 };
+        for (int k = 0; k < 3; k++) {
+            Operand local = LocalOf(*opnds[k], localOf);
+            if (!local.IsNone() && !interferes[local.slot])
+                *opnds[k] = local;
+        }
+        if (code[i].type == TAC_Phi) {
+            vector<Operand> &args = PhiArgs(code[i]);
+            for (int k = 0; k < args.size(); k++) {
+                Operand local = LocalOf(args[k], localOf);
+                if (!local.IsNone() && !interferes[local.slot])
+                    args[k] = local;
+            }
+        }
+        // what is left of a copy between two versions
+        if (code[i].type == TAC_Assign && code[i].dst == code[i].src1 &&
+            code[i].dst.slot == code[i].src1.slot)
+            code[i].deadMarked = 1;
+    }
+    RemoveDeadMarked(code);
+    return numLocals - numInterfering;
+}
+
+// Most versions were merged back into their local and left their slot
+// unused. The ones still in use, and the swap variables, are renumbered
+// from the first version slot on, so the frame layout doesn't scan the
+// rest
+static void CompactVersionSlots(TACFunction *fn) {
+    if (fn->ssaVersions.empty())
+        return;
+    int first = fn->numSlots;
+    for (unordered_map<int, Operand>::iterator it = fn->ssaVersions.begin(); it != fn->ssaVersions.end(); ++it)
+        first = min(first, it->first);
+    vector<int> renumbered(fn->numSlots - first, -1);
+    int next = first;
+    vector<TACObject> &code = fn->code;
+    for (int i = 0; i < code.size(); i++) {
+        Operand *opnds[] = { &code[i].dst, &code[i].src1, &code[i].src2 };
+        for (int k = 0; k < 3; k++) {
+            Operand &o = *opnds[k];
+            if (!o.IsValue() || o.IsGlobal() || o.slot < first)
+                continue;
+            if (renumbered[o.slot - first] < 0)
+                renumbered[o.slot - first] = next++;
+            o.slot = renumbered[o.slot - first];
+        }
+    }
+    fn->numSlots = next;
+}
+
+void DestroySSA(TACFunction *fn) {
+    if (!fn->inSSA)
+        return;
+    vector<TACObject> &code = fn->code;
+    int merged = CoalesceVersions(fn);
+    CFG cfg(code);
+    Insertions inserts;
+    int numCopies = 0, edgesSplit = 0, swaps = 0;
+
+    for (int s = 0; s < cfg.NumBlocks(); s++) {
+        const BasicBlock &block = cfg.blocks[s];
+        int first = AfterLabel(code, block), end = first;
+        for (; end < block.end && code[end].type == TAC_Phi; end++)
+            code[end].deadMarked = 1;
+        if (first == end)
+            continue;
+
+        // the copies of the block above that falls into this one go
+        // right before it, and so do those of an edge from a conditional
+        // jump, in a block of their own
+        const vector<int> &preds = block.preds;
+        vector<TACObject> above;
+        vector<vector<TACObject> > splits;
+        for (int k = 0; k < preds.size(); k++) {
+            vector<TACObject> copies = SequentialCopies(code, first, end, k, fn, swaps);
+            if (copies.empty())
+                continue;
+            numCopies += copies.size();
+            int p = preds[k];
+            TACObject &last = code[cfg.blocks[p].end - 1];
+            if (last.type == TAC_Goto) {
+                inserts.push_back(make_pair(cfg.blocks[p].end - 1, copies));
+                continue;
+            }
+            vector<TACObject> run;
+            if (last.type == TAC_IfGoto) {
+                edgesSplit++;
+                if (cfg.BlockForLabel(last.src2) == s) {
+                    last.src2 = NewLabel();
+                    run.push_back(NewJump(TAC_Label, last.src2));
+                }
+            }
+            run.insert(run.end(), copies.begin(), copies.end());
+            if (p == s - 1)
+                above = run;
+            else
+                splits.push_back(run);
+        }
+
+        const Operand &label = code[block.begin].src1;
+        for (int r = 0; r < splits.size(); r++) {
+            bool fallsIn = r > 0 || (s > 0 && find(preds.begin(), preds.end(), s - 1) != preds.end() &&
+                                     code[cfg.blocks[s - 1].end - 1].type != TAC_Goto);
+            if (fallsIn)
+                above.push_back(NewJump(TAC_Goto, label));
+            above.insert(above.end(), splits[r].begin(), splits[r].end());
+        }
+        if (!above.empty())
+            inserts.push_back(make_pair(block.begin, above));
+    }
+
+    InsertAll(code, inserts);
+    RemoveDeadMarked(code);
+    CompactVersionSlots(fn);
+    fn->inSSA = false;
+    fn->ssaVersions.clear();
+    PrintDebug("ssa", "%s: %d variables merged back, %d copies out of SSA, %d edges split, "
+               "%d swaps", NameOf(fn->name.value).c_str(), merged, numCopies, edgesSplit, swaps);
+}
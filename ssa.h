@@ -0,0 +1,50 @@
+/* File: ssa.h
+ * -----------
+ * Conversion of a function's TAC into SSA form and back.
+ *
+ * Temporaries are already written once by the code generator, so only
+ * locals and parameters that are assigned more than once are renamed.
+ * Phis are placed on the iterated dominance frontiers of a variable's
+ * definitions, but only in blocks where the variable is live on entry,
+ * and each definition then gets a version of its own, name.1, name.2,
+ * ..., with a fresh frame slot, by a walk of the dominator tree. A read
+ * that no definition reaches keeps the original name. Globals can be
+ * changed by any call and are left alone.
+ */
+
+#ifndef _H_ssa
+#define _H_ssa
+
+#include "tac.h"
+#include "analyses.h"
+
+/* Function: BuildSSA
+ * ------------------
+ * Puts a function into SSA form in place. Returns false, doing nothing,
+ * for top-level code and for a function that already is in SSA form.
+ * The "ssa" debug key prints how many variables were renamed and how
+ * many phis placed.
+ */
+bool BuildSSA(TACFunction *fn, AnalysisManager &analyses);
+
+/* Function: NewVersion
+ * --------------------
+ * Gives var a new version, name.n with a fresh frame slot, numbered on
+ * from the last one any pass gave it in this function so no two share a
+ * name. BuildSSA names its versions through it, and so does every pass
+ * that adds some.
+ */
+Operand NewVersion(TACFunction *fn, const Operand &var);
+
+/* Function: DestroySSA
+ * --------------------
+ * Replaces the phis of a function in SSA form by copies at the end of
+ * their predecessors, ordered so that none overwrites a value another
+ * still has to read, with a swap variable to break a cycle. An edge from
+ * a conditional jump into a block with phis gets a block of its own for
+ * the copies, placed right before the phis' block. The code is in normal
+ * form afterwards and the backend can take it.
+ */
+void DestroySSA(TACFunction *fn);
+
+#endif
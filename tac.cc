@@ -0,0 +1,687 @@
+/* File: tac.cc
+ * ------------
+ * Implementation of the compact TAC representation: the name table,
+ * operands, and printing of TAC lines as text and as MIPS.
+ */
+
+#include "tac.h"
+#include "cfg.h"
+#include "loops.h"
+#include "utility.h"
+#include "output.h"
+#include <sstream>
+#include <unordered_map>
+#include <queue>
+#include <set>
+#include <algorithm>
+using namespace std;
+
+const char *allocatableRegisters[] = {
+    "$t3", "$t4", "$t5", "$t6", "$t7", "$t8", "$t9",
+    "$s0", "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7"
+};
+const int numAllocatableRegisters =
+    sizeof(allocatableRegisters) / sizeof(allocatableRegisters[0]);
+
+static const char *argRegisters[] = { "$a0", "$a1", "$a2", "$a3" };
+
+static vector<string> nameTable;
+static unordered_map<string, int> nameIds;
+
+int InternName(const string &name) {
+    unordered_map<string, int>::iterator it = nameIds.find(name);
+    if (it != nameIds.end())
+        return it->second;
+    int id = nameTable.size();
+    nameTable.push_back(name);
+    nameIds[name] = id;
+    return id;
+}
+
+const string &NameOf(int id) {
+    Assert(id >= 0 && id < (int)nameTable.size());
+    return nameTable[id];
+}
+
+int NumInternedNames() {
+    return nameTable.size();
+}
+
+size_t InternedNameBytes() {
+    size_t bytes = 0;
+    for (int i = 0; i < nameTable.size(); i++) {
+        // the string itself, its slot in the table and its hash entry
+        bytes += sizeof(string) + nameTable[i].capacity() + 1;
+        bytes += sizeof(string) + sizeof(int) + 2 * sizeof(void *);
+    }
+    return bytes;
+}
+
+static const char *operatorNames[] = {
+    "", "+", "-", "*", "/", "<", "<=", ">", ">=", "==", "!=", "&&", "||"
+};
+
+TACOperator OperatorFromString(const string &s) {
+    for (int i = OP_Add; i <= OP_Or; i++) {
+        if (s == operatorNames[i])
+            return (TACOperator)i;
+    }
+    return OP_None;
+}
+
+const char *OperatorToString(int op) {
+    return operatorNames[op];
+}
+
+bool IsComparison(int op) {
+    return op >= OP_Lt && op <= OP_Ne;
+}
+
+int SwappedOperator(int op) {
+    if (op == OP_Add || op == OP_Mul || op == OP_Eq || op == OP_Ne || op == OP_And || op == OP_Or)
+        return op;
+    if (op == OP_Gt)
+        return OP_Lt;
+    if (op == OP_Ge)
+        return OP_Le;
+    return OP_None;
+}
+
+int MirroredComparison(int op) {
+    if (op == OP_Lt)
+        return OP_Gt;
+    if (op == OP_Gt)
+        return OP_Lt;
+    if (op == OP_Le)
+        return OP_Ge;
+    if (op == OP_Ge)
+        return OP_Le;
+    return op;
+}
+
+int NegatedComparison(int op) {
+    if (op == OP_Lt)
+        return OP_Ge;
+    if (op == OP_Ge)
+        return OP_Lt;
+    if (op == OP_Le)
+        return OP_Gt;
+    if (op == OP_Gt)
+        return OP_Le;
+    return op == OP_Eq ? OP_Ne : OP_Eq;
+}
+
+bool FoldOperation(int op, const Operand &l, const Operand &r, Operand &result) {
+    int a = l.value, b = r.value;
+    unsigned ua = a, ub = b;
+    switch (op) {
+        case OP_Add: result = Operand::Int((int)(ua + ub)); return true;
+        case OP_Sub: result = Operand::Int((int)(ua - ub)); return true;
+        case OP_Mul: result = Operand::Int((int)(ua * ub)); return true;
+        case OP_Div: if (b == 0 || (b == -1 && a == (int)0x80000000))
+                         return false;
+                     result = Operand::Int(a / b); return true;
+        case OP_Lt:  result = Operand::Bool(a < b); return true;
+        case OP_Le:  result = Operand::Bool(a <= b); return true;
+        case OP_Gt:  result = Operand::Bool(a > b); return true;
+        case OP_Ge:  result = Operand::Bool(a >= b); return true;
+        case OP_Eq:  result = Operand::Bool(a == b); return true;
+        case OP_Ne:  result = Operand::Bool(a != b); return true;
+        case OP_And: result = Operand::Bool(a && b); return true;
+        case OP_Or:  result = Operand::Bool(a || b); return true;
+    }
+    return false;
+}
+
+bool SimplifyOperation(int op, const Operand &l, const Operand &r, Operand &result) {
+    if (l.IsConstant() && r.IsConstant())
+        return FoldOperation(op, l, r, result);
+    if (l.IsConstant() == r.IsConstant())
+        return false;
+
+    bool constantLeft = l.IsConstant();
+    int c = constantLeft ? l.value : r.value;
+    const Operand &x = constantLeft ? r : l;
+    switch (op) {
+        case OP_Add: if (c == 0) { result = x; return true; }
+                     break;
+        case OP_Sub: if (c == 0 && !constantLeft) { result = x; return true; }
+                     break;
+        case OP_Mul: if (c == 1) { result = x; return true; }
+                     if (c == 0) { result = Operand::Int(0); return true; }
+                     break;
+        case OP_Div: if (c == 1 && !constantLeft) { result = x; return true; }
+                     break;
+        case OP_And: result = c ? x : Operand::Bool(false);
+                     return true;
+        case OP_Or:  result = c ? Operand::Bool(true) : x;
+                     return true;
+    }
+    return false;
+}
+
+static int numLabels = 0;
+
+Operand NewLabel() {
+    return Operand::Label(numLabels++);
+}
+
+TACObject NewCopy(const Operand &dst, const Operand &src) {
+    TACObject t;
+    t.type = TAC_Assign;
+    t.dst = dst;
+    t.src1 = src;
+    return t;
+}
+
+TACObject NewOperation(int op, const Operand &dst, const Operand &l, const Operand &r) {
+    TACObject t;
+    t.type = TAC_BinaryOp;
+    t.ops = op;
+    t.dst = dst;
+    t.src1 = l;
+    t.src2 = r;
+    return t;
+}
+
+TACObject NewJump(int type, const Operand &label) {
+    TACObject t;
+    t.type = type;
+    t.src1 = label;
+    return t;
+}
+
+Operand TACFunction::NewVariable(const char *prefix) {
+    int slot = NewSlot();
+    return Operand::Var(InternName(prefix + string(".") + to_string(slot)), slot);
+}
+
+static vector<vector<Operand> > phiArgLists;
+
+TACObject NewPhi(const Operand &dst, int n, const Operand &arg) {
+    TACObject phi;
+    phi.type = TAC_Phi;
+    phi.dst = dst;
+    phi.src1 = Operand::Phi(phiArgLists.size());
+    phiArgLists.push_back(vector<Operand>(n, arg));
+    return phi;
+}
+
+vector<Operand> &PhiArgs(const TACObject &phi) {
+    return phiArgLists[phi.src1.value];
+}
+
+static bool ComesBefore(const pair<int, vector<TACObject> > &a,
+                        const pair<int, vector<TACObject> > &b) {
+    return a.first < b.first;
+}
+
+void InsertAll(vector<TACObject> &code, Insertions &inserts) {
+    stable_sort(inserts.begin(), inserts.end(), ComesBefore);
+    int added = 0;
+    for (int k = 0; k < inserts.size(); k++)
+        added += inserts[k].second.size();
+    int from = code.size();
+    code.resize(from + added);
+    int to = code.size();
+    for (int k = inserts.size() - 1; k >= 0; k--) {
+        while (from > inserts[k].first)
+            code[--to] = code[--from];
+        const vector<TACObject> &run = inserts[k].second;
+        for (int j = run.size() - 1; j >= 0; j--)
+            code[--to] = run[j];
+    }
+}
+
+int RemoveDeadMarked(vector<TACObject> &code) {
+    int kept = 0;
+    for (int i = 0; i < code.size(); i++) {
+        if (code[i].deadMarked == 0) {
+            if (kept != i)
+                code[kept] = code[i];
+            kept++;
+        }
+    }
+    int removed = code.size() - kept;
+    code.resize(kept);
+    return removed;
+}
+
+// MIPS set and branch instructions for the comparison operators
+static const char *setInstructions[] = { "slt", "sle", "sgt", "sge", "seq", "sne" };
+static const char *branchInstructions[] = { "blt", "ble", "bgt", "bge", "beq", "bne" };
+
+ostream &operator<<(ostream &out, const Operand &o) {
+    switch (o.kind) {
+        case OPND_Int:   out << o.value; break;
+        case OPND_Bool:  out << (o.value ? "true" : "false"); break;
+        case OPND_Temp:  out << "t" << o.value; break;
+        case OPND_Label: out << "L" << o.value; break;
+        case OPND_Var:
+        case OPND_Global:
+        case OPND_Func:  out << NameOf(o.value); break;
+    }
+    return out;
+}
+
+void LayoutFrame(TACFunction *fn) {
+    if (fn->IsTopLevel())
+        return;
+    vector<TACObject> &code = fn->code;
+    int n = fn->numSlots;
+    CFG cfg(code);
+    Dominators dom(cfg);
+    LoopInfo loopInfo(cfg, dom);
+
+    // a reference inside a loop counts ten times as much as one just
+    // outside it when choosing what to spill
+    vector<double> depthWeight(loopInfo.MaxDepth() + 1, 1);
+    for (int d = 1; d < depthWeight.size(); d++)
+        depthWeight[d] = depthWeight[d - 1] * 10;
+
+    vector<int> start(n, -1), end(n, -1);
+    vector<double> weight(n, 0);
+    for (int i = 0; i < code.size(); i++) {
+        const Operand *opnds[] = { &code[i].dst, &code[i].src1, &code[i].src2 };
+        for (int k = 0; k < 3; k++) {
+            const Operand &o = *opnds[k];
+            if (!o.IsValue() || o.IsGlobal())
+                continue;
+            if (start[o.slot] < 0)
+                start[o.slot] = i;
+            end[o.slot] = i;
+            weight[o.slot] += depthWeight[loopInfo.Depth(cfg.blockOf[i])];
+        }
+    }
+
+    // A value live into a loop's header is carried around the loop, so
+    // its range must span the whole loop; one that the loop writes before
+    // every read of it, such as a version left over from SSA form, needs
+    // only its own stretch of code. Stretching one range can pull it into
+    // an enclosing loop, hence the fixed point.
+    Liveness liveness(code, cfg);
+    vector<int> indexOf(n, -1);
+    for (int v = 0; v < liveness.NumValues(); v++)
+        indexOf[liveness.ValueAt(v).slot] = v;
+    vector<pair<int, int> > loops;
+    for (int l = 0; l < loopInfo.loops.size(); l++) {
+        const vector<int> &blocks = loopInfo.loops[l].blocks;
+        loops.push_back(make_pair(cfg.blocks[blocks.front()].begin, cfg.blocks[blocks.back()].end - 1));
+    }
+    for (bool changed = !loops.empty(); changed; ) {
+        changed = false;
+        for (int l = 0; l < loops.size(); l++) {
+            int head = loops[l].first, back = loops[l].second;
+            for (int s = 0; s < n; s++) {
+                if (start[s] < 0 || end[s] < head || start[s] > back)
+                    continue;
+                if (indexOf[s] < 0 || !liveness.IsLiveIn(loopInfo.loops[l].header, indexOf[s]))
+                    continue;
+                if (start[s] > head || end[s] < back) {
+                    start[s] = min(start[s], head);
+                    end[s] = max(end[s], back);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // what keeping a range in a register saves per instruction it spans
+    for (int s = 0; s < n; s++) {
+        if (start[s] >= 0)
+            weight[s] /= end[s] - start[s] + 1;
+    }
+
+    // A call runs code that uses the same registers, so anything live
+    // across one has to stay in memory
+    static int readIntName = InternName("readIntFromSTDIN");
+    vector<int> callsBefore(code.size() + 1, 0);
+    fn->outgoingArgs = 0;
+    for (int i = 0; i < code.size(); i++) {
+        bool isCall = code[i].type == TAC_Call && code[i].src1.value != readIntName;
+        callsBefore[i + 1] = callsBefore[i] + (isCall ? 1 : 0);
+        if (code[i].type == TAC_PushParam)
+            fn->outgoingArgs = max(fn->outgoingArgs, code[i].src2.value - 3);
+    }
+    fn->savesRa = callsBefore[code.size()] > 0;
+
+    vector<vector<int> > startingAt(code.size());
+    for (int s = 0; s < n; s++) {
+        if (start[s] >= 0)
+            startingAt[start[s]].push_back(s);
+    }
+
+    // linear scan for registers
+    vector<int> reg(n, -1);
+    vector<int> freeRegs;
+    for (int r = numAllocatableRegisters - 1; r >= 0; r--)
+        freeRegs.push_back(r);
+    set<pair<int, int> > active;   // (end, slot) of ranges holding a register
+    for (int i = 0; i < code.size(); i++) {
+        for (int k = 0; k < startingAt[i].size(); k++) {
+            int s = startingAt[i][k];
+            if (callsBefore[end[s]] - callsBefore[start[s] + 1] > 0)
+                continue;
+            while (!active.empty() && active.begin()->first < i) {
+                freeRegs.push_back(reg[active.begin()->second]);
+                active.erase(active.begin());
+            }
+            if (!freeRegs.empty()) {
+                reg[s] = freeRegs.back();
+                freeRegs.pop_back();
+                active.insert(make_pair(end[s], s));
+                continue;
+            }
+            // out of registers: whichever of these ranges is referenced
+            // least for its length, weighing references by loop depth,
+            // goes to memory, and of equally light ones the one that
+            // ends last
+            set<pair<int, int> >::iterator victim = active.end();
+            for (set<pair<int, int> >::iterator it = active.begin(); it != active.end(); ++it) {
+                if (victim == active.end() || weight[it->second] <= weight[victim->second])
+                    victim = it;
+            }
+            if (weight[victim->second] < weight[s] ||
+                (weight[victim->second] == weight[s] && victim->first > end[s])) {
+                reg[s] = reg[victim->second];
+                reg[victim->second] = -1;
+                active.erase(victim);
+                active.insert(make_pair(end[s], s));
+            }
+        }
+    }
+
+    // linear scan for frame slots over what is left in memory
+    vector<int> frameSlot(n, -1);
+    vector<int> freeSlots;
+    priority_queue<pair<int, int>, vector<pair<int, int> >,
+                   greater<pair<int, int> > > inFrame;  // (end, frame slot)
+    int used = 0, inRegisters = 0;
+    for (int i = 0; i < code.size(); i++) {
+        for (int k = 0; k < startingAt[i].size(); k++) {
+            int s = startingAt[i][k];
+            if (reg[s] >= 0) {
+                inRegisters++;
+                continue;
+            }
+            while (!inFrame.empty() && inFrame.top().first < i) {
+                freeSlots.push_back(inFrame.top().second);
+                inFrame.pop();
+            }
+            if (freeSlots.empty()) {
+                frameSlot[s] = used++;
+            } else {
+                frameSlot[s] = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            inFrame.push(make_pair(end[s], frameSlot[s]));
+        }
+    }
+
+    for (int i = 0; i < code.size(); i++) {
+        Operand *opnds[] = { &code[i].dst, &code[i].src1, &code[i].src2 };
+        for (int k = 0; k < 3; k++) {
+            Operand &o = *opnds[k];
+            if (!o.IsValue() || o.IsGlobal())
+                continue;
+            int s = o.slot;
+            o.inRegister = reg[s] >= 0;
+            o.slot = reg[s] >= 0 ? reg[s] : frameSlot[s];
+        }
+    }
+    fn->numSlots = used;
+    for (int i = 0; i < code.size(); i++) {
+        if (code[i].type == TAC_BeginFunc) {
+            code[i].src1 = Operand::Int(fn->FrameBytes());
+            break;
+        }
+    }
+    PrintDebug("frame", "%s: %d values, %d in registers, %d frame slots, %d byte frame",
+               NameOf(fn->name.value).c_str(), n, inRegisters, used, fn->FrameBytes());
+}
+
+void ReportTACMemory(const vector<TACFunction*> &functions) {
+    if (!IsDebugOn("tacmem"))
+        return;
+    size_t instrBytes = 0;
+    int n = 0;
+    for (int f = 0; f < functions.size(); f++) {
+        instrBytes += sizeof(TACFunction) + functions[f]->code.capacity() * sizeof(TACObject);
+        n += functions[f]->code.size();
+    }
+    size_t nameBytes = InternedNameBytes();
+    PrintDebug("tacmem", "%d instructions, %d bytes per instruction",
+               n, (int)sizeof(TACObject));
+    PrintDebug("tacmem", "%d interned names, %d bytes",
+               NumInternedNames(), (int)nameBytes);
+    PrintDebug("tacmem", "%d bytes total, %.1f bytes per instruction",
+               (int)(instrBytes + nameBytes),
+               n ? (double)(instrBytes + nameBytes) / n : 0.0);
+}
+
+void TACObject::printByLines() {
+    switch (type) {
+        case TAC_Print:     Output() << "    Print " << src1 << '\n';
+                            break;
+        case TAC_Label:     Output() << src1 << ":" << '\n';
+                            break;
+        case TAC_BinaryOp:  Output() << "    " << dst << " := " << src1
+                                 << " " << OperatorToString(ops) << " " << src2 << '\n';
+                            break;
+        case TAC_Assign:    Output() << "    " << dst << " := " << src1 << '\n';
+                            break;
+        case TAC_FuncLabel: Output() << src1 << ":" << '\n';
+                            break;
+        case TAC_EndFunc:   Output() << "    EndFunc " << '\n';
+                            break;
+        case TAC_BeginFunc: Output() << "    BeginFunc " << src1 << '\n';
+                            break;
+        case TAC_PushParam: Output() << "    PushParam " << src1 << '\n';
+                            break;
+        case TAC_LoadParam: Output() << "    LoadParam " << dst << '\n';
+                            break;
+        case TAC_PopParam:  Output() << "    PopParam " << src1 << '\n';
+                            break;
+        case TAC_Call:      Output() << "    " << dst << " call "
+                                 << src1 << " " << src2 << '\n';
+                            break;
+        case TAC_Return:    Output() << "    Return " << src1 << '\n';
+                            break;
+        case TAC_IfGoto:    Output() << "    if " << src1 << " goto " << src2 << '\n';
+                            break;
+        case TAC_Goto:      Output() << "    goto " << src1 << '\n';
+                            break;
+        case TAC_Phi: {     const vector<Operand> &args = PhiArgs(*this);
+                            Output() << "    " << dst << " := phi(";
+                            for (int k = 0; k < args.size(); k++)
+                                Output() << (k > 0 ? ", " : "") << args[k];
+                            Output() << ")" << '\n';
+                            break;
+        }
+    }
+}
+
+// Memory operand for the storage behind a temp, variable or global.
+// Globals, and everything top-level code uses, are in the global area.
+static string addressOf(const TACFunction &fn, const Operand &o) {
+    ostringstream out;
+    if (o.IsGlobal() || fn.IsTopLevel())
+        out << "_globals+" << 4 * o.slot;
+    else
+        out << fn.SlotOffset(o.slot) << "($sp)";
+    return out.str();
+}
+
+// Loads an immediate or the value of a temp or variable into reg
+static void loadOperand(const TACFunction &fn, const char *reg, const Operand &o) {
+    if (o.IsConstant())
+        Output() << "    li " << reg << ", " << o.value << '\n';
+    else if (o.inRegister)
+        Output() << "    move " << reg << ", " << allocatableRegisters[o.slot] << '\n';
+    else
+        Output() << "    lw " << reg << ", " << addressOf(fn, o) << '\n';
+}
+
+// Register to read o from: its own, or scratch loaded with its value
+static const char *useOperand(const TACFunction &fn, const char *scratch, const Operand &o) {
+    if (o.inRegister)
+        return allocatableRegisters[o.slot];
+    loadOperand(fn, scratch, o);
+    return scratch;
+}
+
+// Register to compute a value for o into: its own, or scratch, which
+// storeOperand then writes back
+static const char *defOperand(const char *scratch, const Operand &o) {
+    return o.inRegister ? allocatableRegisters[o.slot] : scratch;
+}
+
+// Writes reg to the storage of o, unless reg already is o's register
+static void storeOperand(const TACFunction &fn, const char *reg, const Operand &o) {
+    if (!o.inRegister)
+        Output() << "    sw " << reg << ", " << addressOf(fn, o) << '\n';
+    else if (reg != allocatableRegisters[o.slot])
+        Output() << "    move " << allocatableRegisters[o.slot] << ", " << reg << '\n';
+}
+
+static void printEpilogue(const TACFunction &fn) {
+    if (fn.savesRa)
+        Output() << "    lw $ra, " << fn.FrameBytes() - 4 << "($sp)" << '\n';
+    if (fn.FrameBytes() > 0)
+        Output() << "    addiu $sp, $sp, " << fn.FrameBytes() << '\n';
+    Output() << "    jr $ra" << '\n';
+}
+
+void TACObject::printMips(const TACFunction &fn) const {
+    static int readIntName = InternName("readIntFromSTDIN");
+    const char *l, *r, *d, *instr;
+    switch (type) {
+        case TAC_Print:     loadOperand(fn, "$a0", src1);
+                            Output() << "    li $v0, 1" << '\n';
+                            Output() << "    syscall" << '\n';
+                            break;
+        case TAC_Label:     Output() << src1 << ":" << '\n';
+                            break;
+        case TAC_BinaryOp:  l = useOperand(fn, "$t1", src1);
+                            r = useOperand(fn, "$t2", src2);
+                            d = defOperand("$t0", dst);
+                            if (IsComparison(ops)) {
+                                instr = setInstructions[ops - OP_Lt];
+                            }
+                            else {
+                                // the language wraps around on overflow, as
+                                // folding does, where add and sub would trap
+                                instr = ops == OP_Add ? "addu" :
+                                        ops == OP_Sub ? "subu" :
+                                        ops == OP_Mul ? "mul" :
+                                        ops == OP_Div ? "div" :
+                                        ops == OP_And ? "and" : "or";
+                            }
+                            Output() << "    " << instr << " " << d << ", " << l << ", " << r << '\n';
+                            storeOperand(fn, d, dst);
+                            break;
+
+        case TAC_Assign:    // a value in a register is stored from there
+                            d = useOperand(fn, defOperand("$t0", dst), src1);
+                            storeOperand(fn, d, dst);
+                            break;
+
+        case TAC_FuncLabel: Output() << src1 << ":" << '\n';
+                            if (fn.FrameBytes() > 0)
+                                Output() << "    addiu $sp, $sp, " << -fn.FrameBytes() << '\n';
+                            if (fn.savesRa)
+                                Output() << "    sw $ra, " << fn.FrameBytes() - 4 << "($sp)" << '\n';
+                            break;
+
+        case TAC_BeginFunc: break;
+
+        // the first four arguments travel in $a0-$a3, the rest in the
+        // caller's outgoing area at the bottom of its frame
+        case TAC_PushParam: if (src2.value < 4) {
+                                loadOperand(fn, argRegisters[src2.value], src1);
+                            }
+                            else {
+                                l = useOperand(fn, "$t0", src1);
+                                Output() << "    sw " << l << ", " << 4 * (src2.value - 4) << "($sp)" << '\n';
+                            }
+                            break;
+
+        case TAC_LoadParam: if (src1.value < 4) {
+                                storeOperand(fn, argRegisters[src1.value], dst);
+                            }
+                            else {
+                                d = defOperand("$t0", dst);
+                                Output() << "    lw " << d << ", " << fn.FrameBytes() + 4 * (src1.value - 4)
+                                     << "($sp)" << '\n';
+                                storeOperand(fn, d, dst);
+                            }
+                            break;
+
+        case TAC_PopParam:  break;
+
+        case TAC_Call:      if (src1.value == readIntName) {
+                                Output() << "    li $v0, 5" << '\n';
+                                Output() << "    syscall" << '\n';
+                            }
+                            else {
+                                Output() << "    jal " << src1 << '\n';
+                            }
+                            storeOperand(fn, "$v0", dst);
+                            break;
+
+        case TAC_Return:    if (!src1.IsNone())
+                                loadOperand(fn, "$v0", src1);
+                            printEpilogue(fn);
+                            break;
+
+        case TAC_EndFunc:   printEpilogue(fn);
+                            break;
+
+        case TAC_IfGoto:    l = useOperand(fn, "$t0", src1);
+                            Output() << "    bne " << l << ", $zero, " << src2 << '\n';
+                            break;
+
+        case TAC_Goto:      Output() << "    j " << src1 << '\n';
+                            break;
+    }
+}
+
+void PrintMips(const TACFunction &fn, int begin, int end) {
+    const vector<TACObject> &code = fn.code;
+    unordered_map<Operand, int, OperandHash> uses;
+    for (int i = 0; i < code.size(); i++) {
+        if (code[i].src1.IsTemp())
+            uses[code[i].src1]++;
+        if (code[i].src2.IsTemp())
+            uses[code[i].src2]++;
+    }
+    for (int i = begin; i < end; i++) {
+        const TACObject &t = code[i];
+        if (i + 1 < end && t.type == TAC_BinaryOp && IsComparison(t.ops) &&
+            t.dst.IsTemp() && code[i + 1].type == TAC_IfGoto &&
+            code[i + 1].src1 == t.dst && uses[t.dst] == 1) {
+            // a constant on the right becomes the branch's immediate
+            const char *l = useOperand(fn, "$t1", t.src1);
+            string r = t.src2.IsConstant() ? to_string(t.src2.value)
+                                           : useOperand(fn, "$t2", t.src2);
+            Output() << "    " << branchInstructions[t.ops - OP_Lt] << " " << l << ", "
+                     << r << ", " << code[i + 1].src2 << '\n';
+            i++;
+            continue;
+        }
+        if (i + 1 < end && t.type == TAC_BinaryOp && t.dst.IsTemp() &&
+            code[i + 1].type == TAC_Assign && code[i + 1].src1 == t.dst && uses[t.dst] == 1) {
+            // a temp only copied is computed straight into the copy
+            TACObject merged = t;
+            merged.dst = code[i + 1].dst;
+            merged.printMips(fn);
+            i++;
+            continue;
+        }
+        // nothing falls off the end after a return or jump, so there is
+        // no second epilogue
+        if (t.type == TAC_EndFunc && i > 0 && (code[i - 1].type == TAC_Return || code[i - 1].type == TAC_Goto))
+            continue;
+        code[i].printMips(fn);
+    }
+}
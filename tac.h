@@ -0,0 +1,309 @@
+/* File: tac.h
+ * -----------
+ * This file defines the in-memory form of the three-address code (TAC)
+ * produced by the Emit() methods of the ast nodes.
+ *
+ * Each line of TAC is a TACObject: a one byte opcode (TACType), a one
+ * byte operator for binary operations, a handful of bit-packed flags and
+ * three fixed operand slots. Operands are small tagged values: an integer
+ * or boolean immediate, a numbered temporary (virtual register), a
+ * numbered label, or a variable or function name. Names are stored once
+ * in a global name table and referred to by id everywhere else, so
+ * copying, comparing and hashing an operand never touches a string.
+ * Emit() returns the Operand holding the value of the expression.
+ *
+ * Temporaries, locals and parameters are given a stack slot in their
+ * function when Emit() first resolves them, and globals a slot in the
+ * global area, so the backend reads storage straight from the operand.
+ *
+ * Which operand slots are used depends on the opcode:
+ *
+ *    TAC_Assign      dst := src1
+ *    TAC_BinaryOp    dst := src1 ops src2
+ *    TAC_FuncLabel   src1:                     (function name)
+ *    TAC_BeginFunc   BeginFunc src1            (frame size in bytes)
+ *    TAC_EndFunc     EndFunc
+ *    TAC_PushParam   PushParam src1            (src2: argument index)
+ *    TAC_PopParam    PopParam src1             (bytes popped)
+ *    TAC_LoadParam   LoadParam dst             (src1: parameter index)
+ *    TAC_Call        dst call src1 src2        (function name, arg count)
+ *    TAC_Return      Return src1
+ *    TAC_IfGoto      if src1 goto src2         (label)
+ *    TAC_Goto        goto src1                 (label)
+ *    TAC_Label       src1:                     (label)
+ *    TAC_Print       Print src1
+ *    TAC_Phi         dst := phi(...)           (src1: argument list)
+ *
+ * Phis only appear while a function is in SSA form. Their arguments
+ * don't fit in the instruction, so src1 refers to a list kept on the
+ * side, with one argument per predecessor of the phi's block in the
+ * order the CFG lists them.
+ */
+
+#ifndef _H_tac
+#define _H_tac
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+enum TACType {
+    TAC_Nop       = 0,
+    TAC_Assign    = 2,
+    TAC_FuncLabel = 3,
+    TAC_EndFunc   = 4,
+    TAC_BeginFunc = 5,
+    TAC_PushParam = 6,
+    TAC_PopParam  = 7,
+    TAC_Call      = 8,
+    TAC_Return    = 9,
+    TAC_IfGoto    = 10,
+    TAC_Goto      = 11,
+    TAC_BinaryOp  = 12,
+    TAC_Label     = 13,
+    TAC_Print     = 14,
+    TAC_Phi       = 15,
+    TAC_LoadParam = 77
+};
+
+enum TACOperator {
+    OP_None, OP_Add, OP_Sub, OP_Mul, OP_Div,
+    OP_Lt, OP_Le, OP_Gt, OP_Ge, OP_Eq, OP_Ne, OP_And, OP_Or
+};
+
+TACOperator OperatorFromString(const string &s);
+const char *OperatorToString(int op);
+
+/* Name table
+ * ----------
+ * InternName returns the id of a name, adding it to the table the first
+ * time it is seen. NameOf maps an id back to its spelling for printing.
+ */
+int InternName(const string &name);
+const string &NameOf(int id);
+int NumInternedNames();
+size_t InternedNameBytes();
+
+enum OperandKind {
+    OPND_None, OPND_Int, OPND_Bool, OPND_Temp, OPND_Var, OPND_Label, OPND_Func,
+    OPND_Global, OPND_Phi
+};
+
+struct Operand {
+    int value;          // immediate, temp/label number or interned name id
+    unsigned kind : 7;  // OperandKind
+    unsigned inRegister : 1;
+    unsigned slot : 24; // stack slot of a temp or variable, global slot of a
+                        // global, or once allocated, register number
+
+    Operand() : value(0), kind(OPND_None), inRegister(0), slot(0) {}
+    Operand(OperandKind k, int v, int s = 0) : value(v), kind(k), inRegister(0), slot(s) {}
+
+    static Operand Int(int v)              { return Operand(OPND_Int, v); }
+    static Operand Bool(bool v)            { return Operand(OPND_Bool, v ? 1 : 0); }
+    static Operand Temp(int n, int slot)   { return Operand(OPND_Temp, n, slot); }
+    static Operand Label(int n)            { return Operand(OPND_Label, n); }
+    static Operand Var(int name, int slot) { return Operand(OPND_Var, name, slot); }
+    static Operand Global(int name, int slot) { return Operand(OPND_Global, name, slot); }
+    static Operand Func(const char *name)  { return Operand(OPND_Func, InternName(name)); }
+    static Operand Phi(int list)           { return Operand(OPND_Phi, list); }
+
+    bool IsNone() const     { return kind == OPND_None; }
+    bool IsConstant() const { return kind == OPND_Int || kind == OPND_Bool; }
+    bool IsTemp() const     { return kind == OPND_Temp; }
+    bool IsVar() const      { return kind == OPND_Var || kind == OPND_Global; }
+    bool IsGlobal() const   { return kind == OPND_Global; }
+    // a temporary or variable, i.e. something that lives in storage
+    bool IsValue() const    { return kind == OPND_Temp || IsVar(); }
+
+    bool operator==(const Operand &o) const { return kind == o.kind && value == o.value; }
+    bool operator!=(const Operand &o) const { return !(*this == o); }
+    bool operator<(const Operand &o) const
+        { return kind != o.kind ? kind < o.kind : value < o.value; }
+};
+
+ostream &operator<<(ostream &out, const Operand &o);
+
+struct OperandHash {
+    size_t operator()(const Operand &o) const { return (size_t)o.value * 8 + o.kind; }
+};
+
+struct TACFunction;
+
+struct TACObject {
+    unsigned char type;                 // TACType
+    unsigned char ops;                  // TACOperator for TAC_BinaryOp
+
+    unsigned short getFolded : 1;
+    unsigned short deadMarked : 1;
+    unsigned short declares : 1;        // first definition of dst
+
+    Operand dst;
+    Operand src1;
+    Operand src2;
+
+    TACObject() : type(TAC_Nop), ops(OP_None), getFolded(0), deadMarked(0),
+                  declares(0) {}
+
+    void printByLines();
+    void printMips(const TACFunction &fn) const;
+};
+
+bool IsComparison(int op);
+// The operator giving the same result with the operands swapped, or
+// OP_None if there is none
+int SwappedOperator(int op);
+// The comparison giving the same result with the operands swapped, and
+// the one true exactly when op is false
+int MirroredComparison(int op);
+int NegatedComparison(int op);
+
+/* Function: NewLabel
+ * ------------------
+ * A label no other code uses yet, for the code generator and for passes
+ * that add blocks.
+ */
+Operand NewLabel();
+
+/* Function: NewCopy, NewOperation, NewJump
+ * -----------------------------------------
+ * Make the instructions passes add to the code: dst := src, dst := l op
+ * r, and a label or goto of the given type naming label.
+ */
+TACObject NewCopy(const Operand &dst, const Operand &src);
+TACObject NewOperation(int op, const Operand &dst, const Operand &l, const Operand &r);
+TACObject NewJump(int type, const Operand &label);
+
+/* Function: NewPhi, PhiArgs
+ * -------------------------
+ * NewPhi makes a phi for dst with n arguments, all set to arg. PhiArgs
+ * gives the argument list of a phi, which passes may edit in place.
+ */
+TACObject NewPhi(const Operand &dst, int n, const Operand &arg);
+vector<Operand> &PhiArgs(const TACObject &phi);
+
+/* Function: FoldOperation
+ * -----------------------
+ * Computes l op r for two constants, wrapping around on overflow like the
+ * addu, subu and mul the backend emits for them. Comparisons and logical operators give a boolean. Returns
+ * false, leaving result alone, for a division that would trap.
+ */
+bool FoldOperation(int op, const Operand &l, const Operand &r, Operand &result);
+
+/* Function: SimplifyOperation
+ * ---------------------------
+ * Reduces l op r to a single operand when one or both sides are
+ * constants: operations on two constants are folded, and an identity or
+ * absorbing constant (x + 0, x * 1, x * 0, true && x, ...) gives the
+ * other side or the constant. Returns false if neither applies. Dropping
+ * the other side is only right if computing it has no effects.
+ */
+bool SimplifyOperation(int op, const Operand &l, const Operand &r, Operand &result);
+
+/* Function: RemoveDeadMarked
+ * --------------------------
+ * Deletes the instructions that have deadMarked set, sliding the rest
+ * down in a single pass, and returns how many there were. Passes mark
+ * what they delete and sweep once at the end, so deleting an instruction
+ * costs O(1) and the code is never copied.
+ */
+int RemoveDeadMarked(vector<TACObject> &code);
+
+/* Function: InsertAll
+ * -------------------
+ * Inserts runs of instructions into the code, each before the instruction
+ * at the given index of the code as it was. Does them all in one sweep
+ * from the back, so each instruction moves at most once; runs at the
+ * same index keep their order.
+ */
+typedef vector<pair<int, vector<TACObject> > > Insertions;
+void InsertAll(vector<TACObject> &code, Insertions &inserts);
+
+/* Struct: TACFunction
+ * -------------------
+ * The TAC of one function, or of a run of top-level declarations (which
+ * have no name). Each function owns its instruction buffer, and its frame
+ * size grows as Emit() allocates stack slots, so finishing a function
+ * never has to look at the code of any other.
+ *
+ * Slots are numbered from 0 in the order names and temporaries are first
+ * resolved, parameters first; varSlots maps a name id to its slot. Once
+ * the function is complete LayoutFrame moves as many as it can into
+ * registers and renumbers the rest so that values whose lifetimes don't
+ * overlap share a frame slot. Top-level code has no frame: its
+ * temporaries live in the global area next to the globals.
+ */
+struct TACFunction {
+    Operand name;               // OPND_Func, or none for top-level code
+    vector<TACObject> code;
+    int frameSize;              // bytes of stack allocated so far
+    int beginFunc;              // index of the BeginFunc line, or -1
+    unordered_map<int, int> varSlots;
+    int numSlots;
+    int outgoingArgs;           // stack words for arguments past the 4th
+    bool savesRa;               // makes calls, so $ra goes in the frame
+    bool inSSA;                 // locals are renamed and joined by phis
+    unordered_map<int, Operand> ssaVersions;    // slot of each version of
+                                                // a local -> the local
+    unordered_map<int, int> lastVersion;        // by name id, the last
+                                                // number NewVersion gave
+
+    TACFunction(Operand n = Operand()) : name(n), frameSize(0), beginFunc(-1),
+                                         numSlots(0), outgoingArgs(0), savesRa(false),
+                                         inSSA(false) {}
+    bool IsTopLevel() const { return name.IsNone(); }
+    int NewSlot() { return numSlots++; }
+    // A local of its own for a pass to write, named prefix.slot
+    Operand NewVariable(const char *prefix);
+
+    /* The frame, from $sp up: outgoing arguments past the 4th, the frame
+     * slots, and the saved $ra if any. The caller's own stack arguments
+     * sit right above it.
+     */
+    int FrameBytes() const { return 4 * (outgoingArgs + numSlots + (savesRa ? 1 : 0)); }
+    int SlotOffset(int slot) const { return 4 * (outgoingArgs + slot); }
+};
+
+/* Function: LayoutFrame
+ * ---------------------
+ * Computes the live range of every slot of a function as an interval of
+ * instruction indices, stretching ranges of values that are live around a
+ * loop to cover the whole loop. A linear scan over the ranges in order of
+ * their start then gives each value one of the allocatable registers.
+ * When they run out, the range with the fewest references goes to memory,
+ * a reference in a loop counting ten times one outside it, so values used
+ * in inner loops keep their registers. Values live across a call, and
+ * spilled ones, get frame slots by a second scan that reuses a slot once
+ * the range holding it has ended. Operands are rewritten to their
+ * register or frame slot and numSlots shrinks to the frame actually
+ * needed. It also sizes the outgoing argument area and decides whether
+ * $ra must be saved, and sets the size in BeginFunc to the frame the
+ * prologue allocates. The TAC is printed before this, so its BeginFunc
+ * shows 4 bytes for every slot Emit() allocated instead. The "frame"
+ * debug key reports the result.
+ */
+void LayoutFrame(TACFunction *fn);
+
+// Registers handed out by LayoutFrame; $t0-$t2 are backend scratch and
+// $a0-$a3 carry the first four arguments of a call
+extern const char *allocatableRegisters[];
+extern const int numAllocatableRegisters;
+
+/* Function: PrintMips
+ * --------------------
+ * Prints the MIPS for lines [begin, end) of a laid out function. A
+ * comparison whose only use is the conditional jump right after it is
+ * fused with the jump into a single compare-and-branch.
+ */
+void PrintMips(const TACFunction &fn, int begin, int end);
+
+/* Function: ReportTACMemory
+ * -------------------------
+ * Prints (under the "tacmem" debug key) how much memory the instruction
+ * buffers and the name table take, per instruction and in total.
+ */
+void ReportTACMemory(const vector<TACFunction*> &functions);
+
+#endif
@@ -1,4 +1,10 @@
 #!/bin/bash
+#
+# Every samples/NAME.java is compiled to TAC at -O0 and compared with
+# NAME.out, and at -On with NAME.On.out where there is one. A sample with
+# a NAME.expect is also compiled to MIPS at every -O level and run in
+# mipsim.py, with the integers in NAME.in as its input if there is one,
+# and must print what NAME.expect holds.
 
 echo "Running tests..."
 
@@ -11,18 +17,44 @@ fi
 failed=0
 touch .myout
 
-for INPUT_FILE in $(ls samples/*.java); do
-  echo -n "testing $INPUT_FILE..."
-  ./parser < $INPUT_FILE &> .myout
-  diff=$(diff .myout ${INPUT_FILE/java/out})
+# compares .myout with the expected file $1
+check() {
+  diff=$(diff .myout $1 2>&1)
   if [ "$diff" != "" ]; then
     echo "failed!"
-    echo "$thediff"
+    echo "$diff"
     echo
     failed=$(( $failed + 1 ))
   else
     echo "passed!"
   fi
+}
+
+for INPUT_FILE in $(ls samples/*.java); do
+  echo -n "testing $INPUT_FILE..."
+  ./parser --emit=tac < $INPUT_FILE &> .myout
+  check ${INPUT_FILE/java/out}
+
+  base=${INPUT_FILE%.java}
+  for level in 1 2 3; do
+    if [ -e $base.O$level.out ]; then
+      echo -n "testing $INPUT_FILE at -O$level..."
+      ./parser -O$level --emit=tac < $INPUT_FILE &> .myout
+      check $base.O$level.out
+    fi
+  done
+
+  if [ -e $base.expect ]; then
+    input=$( [ -e $base.in ] && cat $base.in )
+    for level in 0 1 2 3; do
+      echo -n "running $INPUT_FILE at -O$level..."
+      ./parser -O$level --emit=mips < $INPUT_FILE > .mymips 2>&1 &&
+        python3 mipsim.py .mymips $input > .myout 2>/dev/null ||
+        echo "(did not compile or run)" >> .myout
+      check $base.expect
+    done
+    rm -f .mymips
+  fi
 done
 
 rm .myout
@@ -31,4 +63,4 @@ if (( $failed )); then
   echo "===== failed $failed tests"
 else
   echo "===== passed all tests! :)"
-fi
\ No newline at end of file
+fi
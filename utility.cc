@@ -11,6 +11,11 @@
 using std::vector;
 
 static vector<const char*> debugKeys;
+static const char *outputFileName = NULL;
+static EmitMode emitMode = EmitBoth;
+static int optLevel = 0;
+static const char *passList = NULL;
+static bool fixedPoint = false;
 static const int BufferSize = 2048;
 
 void Failure(const char *format, ...) {
@@ -58,19 +63,57 @@ void PrintDebug(const char *key, const char *format, ...) {
   printf("+++ (%s): %s%s", key, buf, buf[strlen(buf)-1] != '\n'? "\n" : "");
 }
 
+static void Usage(int argc, char *argv[]) {
+  printf("Incorrect Use:   ");
+  for (int i = 1; i < argc; i++) printf("%s ", argv[i]);
+  printf("\n");
+  printf("Correct Usage:   [-d <debug-key-1> <debug-key-2> ...] [-o <file>] [--emit=tac|mips|both]\n"
+         "                 [-O0|-O1|-O2|-O3] [--passes=<pass>,...] [--fixed-point]\n");
+  exit(2);
+}
+
 void ParseCommandLine(int argc, char *argv[]) {
-  if (argc == 1)
-    return;
-  
-  if (strcmp(argv[1], "-d") != 0) { // first arg is not -d
-    printf("Incorrect Use:   ");
-    for (int i = 1; i < argc; i++) printf("%s ", argv[i]);
-    printf("\n");
-    printf("Correct Usage:   -d <debug-key-1> <debug-key-2> ... \n");
-    exit(2);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-d") == 0) {
+      while (i + 1 < argc && argv[i + 1][0] != '-')
+        SetDebugForKey(argv[++i], true);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      outputFileName = argv[++i];
+    } else if (strcmp(argv[i], "--emit=tac") == 0) {
+      emitMode = EmitTAC;
+    } else if (strcmp(argv[i], "--emit=mips") == 0) {
+      emitMode = EmitMips;
+    } else if (strcmp(argv[i], "--emit=both") == 0) {
+      emitMode = EmitBoth;
+    } else if (strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '3' &&
+               argv[i][3] == '\0') {
+      optLevel = argv[i][2] - '0';
+    } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+      passList = argv[i] + 9;
+    } else if (strcmp(argv[i], "--fixed-point") == 0) {
+      fixedPoint = true;
+    } else {
+      Usage(argc, argv);
+    }
   }
+}
+
+const char *GetOutputFileName() {
+  return outputFileName;
+}
 
-  for (int i = 2; i < argc; i++)
-    SetDebugForKey(argv[i], true);
+EmitMode GetEmitMode() {
+  return emitMode;
 }
 
+int GetOptLevel() {
+  return optLevel;
+}
+
+const char *GetPassList() {
+  return passList;
+}
+
+bool GetFixedPoint() {
+  return fixedPoint;
+}
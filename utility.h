@@ -76,11 +76,40 @@ bool IsDebugOn(const char *key);
 /**
  * Function: ParseCommandLine
  * --------------------------
- * Turn on the debugging flags from the command line.  Verifies that
- * first argument is -d, and then interpret all the arguments that follow
- * as being flags to turn on.
+ * Turn on the debugging flags from the command line and read the output
+ * options. Accepts, in any order:
+ *   -d <debug-key-1> <debug-key-2> ...   flags to turn on
+ *   -o <file>                            write the output to file
+ *   --emit=tac|mips|both                 what to output (default both)
+ *   -O0 -O1 -O2 -O3                      optimization level (default -O0)
+ *   --passes=<pass>,...                  run these passes instead
+ *   --fixed-point                        repeat them until nothing changes
  */
 
 void ParseCommandLine(int argc, char *argv[]);
+
+/**
+ * Function: GetOutputFileName(), GetEmitMode()
+ * --------------------------------------------
+ * The output options given on the command line. The file name is NULL
+ * when the output goes to stdout.
+ */
+
+enum EmitMode { EmitTAC = 1, EmitMips = 2, EmitBoth = EmitTAC | EmitMips };
+
+const char *GetOutputFileName();
+EmitMode GetEmitMode();
+
+/**
+ * Function: GetOptLevel(), GetPassList(), GetFixedPoint()
+ * -------------------------------------------------------
+ * The optimization options given on the command line. The pass list is
+ * NULL unless --passes= was given, in which case it replaces the
+ * pipeline of the optimization level.
+ */
+
+int GetOptLevel();
+const char *GetPassList();
+bool GetFixedPoint();
      
 #endif